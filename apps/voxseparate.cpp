@@ -27,40 +27,6 @@
 #include "../src/ogt_vox.h"
 
 
-// a helper function to load a magica voxel scene given a filename.
-const ogt_vox_scene* load_vox_scene(const char* filename, uint32_t scene_read_flags = 0)
-{
-    // open the file
-#if defined(_MSC_VER) && _MSC_VER >= 1400
-    FILE * fp;
-    if (0 != fopen_s(&fp, filename, "rb"))
-        fp = 0;
-#else
-    FILE * fp = fopen(filename, "rb");
-#endif
-    if (!fp)
-        return NULL;
-
-    // get the buffer size which matches the size of the file
-    fseek(fp, 0, SEEK_END);
-    uint32_t buffer_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    // load the file into a memory buffer
-    uint8_t * buffer = new uint8_t[buffer_size];
-    fread(buffer, buffer_size, 1, fp);
-    fclose(fp);
-
-    // construct the scene from the buffer
-    const ogt_vox_scene * scene = ogt_vox_read_scene_with_flags(buffer, buffer_size, scene_read_flags);
-
-    // the buffer can be safely deleted once the scene is instantiated.
-    delete[] buffer;
-
-    return scene;
-}
-
-
 // a helper function to save a magica voxel scene to disk.
 void save_vox_scene(const char* pcFilename, const ogt_vox_scene* scene)
 {
@@ -135,7 +101,7 @@ int32_t main(int32_t argc, char** argv) {
         printf("processing input %s\n", input_filename);
 
         // load scene
-        const ogt_vox_scene* scene = load_vox_scene(input_filename);
+        const ogt_vox_scene* scene = ogt_vox_read_scene_from_file(input_filename, 0);
         if (!scene) {
             printf("ERROR: could not load scene with name '%s'\n", input_filename);
             return 5;
@@ -16,44 +16,6 @@
 #endif
 #include <stdio.h>
 
-// a helper function to load a magica voxel scene given a filename.
-const ogt_vox_scene* load_vox_scene(const char* filename, uint32_t scene_read_flags = 0)
-{
-    // open the file
-#if defined(_MSC_VER) && _MSC_VER >= 1400
-    FILE * fp;
-    if (0 != fopen_s(&fp, filename, "rb"))
-        fp = 0;
-#else
-    FILE * fp = fopen(filename, "rb");
-#endif
-    if (!fp)
-        return NULL;
-
-    // get the buffer size which matches the size of the file
-    fseek(fp, 0, SEEK_END);
-    uint32_t buffer_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    // load the file into a memory buffer
-    uint8_t * buffer = new uint8_t[buffer_size];
-    fread(buffer, buffer_size, 1, fp);
-    fclose(fp);
-
-    // construct the scene from the buffer
-    const ogt_vox_scene * scene = ogt_vox_read_scene_with_flags(buffer, buffer_size, scene_read_flags);
-
-    // the buffer can be safely deleted once the scene is instantiated.
-    delete[] buffer;
-
-    return scene;
-}
-
-const ogt_vox_scene* load_vox_scene_with_groups(const char* filename)
-{
-    return load_vox_scene(filename, k_read_scene_flags_groups);
-}
-
 // a helper function to save a magica voxel scene to disk.
 void save_vox_scene(const char* pcFilename, const ogt_vox_scene* scene) 
 {
@@ -85,25 +47,16 @@ void save_vox_scene(const char* pcFilename, const ogt_vox_scene* scene)
 // would probably do something like convert the model into a triangle mesh.
 uint32_t count_solid_voxels_in_model(const ogt_vox_model* model)
 {
-    uint32_t solid_voxel_count = 0;
-    uint32_t voxel_index = 0;
-    for (uint32_t z = 0; z < model->size_z; z++) {
-        for (uint32_t y = 0; y < model->size_y; y++) {
-            for (uint32_t x = 0; x < model->size_x; x++, voxel_index++) {
-                // if color index == 0, this voxel is empty, otherwise it is solid.
-                uint32_t color_index = model->voxel_data[voxel_index];
-                bool is_voxel_solid = (color_index != 0);
-                // add to our accumulator
-                solid_voxel_count += (is_voxel_solid ? 1 : 0);
-            }
-        }
-    }
-    return solid_voxel_count;
+    // voxels are stored with x varying fastest, then y, then z. A color index of 0 means the voxel
+    // is empty, otherwise it is solid. ogt_vox_count_solid_voxels counts them using SIMD where available.
+    uint32_t num_voxels = model->size_x * model->size_y * model->size_z;
+    return ogt_vox_count_solid_voxels(model->voxel_data, num_voxels);
 }
 
 void demo_load_and_save()
 {
-    const ogt_vox_scene* scene = load_vox_scene_with_groups("vox/test_groups.vox");
+    // the file is memory-mapped and parsed in place.
+    const ogt_vox_scene* scene = ogt_vox_read_scene_from_file("vox/test_groups.vox", k_read_scene_flags_groups);
     if (scene)
     {
         printf("#layers: %u\n", scene->num_layers);
@@ -177,12 +130,12 @@ void demo_load_and_save()
 void demo_merge_scenes()
 {
     const ogt_vox_scene* scenes[] = {
-        load_vox_scene("vox/chr_old.vox"),
-        load_vox_scene("vox/chr_rain.vox"),
-        load_vox_scene("vox/chr_sword.vox"),
-        load_vox_scene("vox/chr_knight.vox"),
-        load_vox_scene("vox/doom.vox"),
-        load_vox_scene_with_groups("vox/test_groups.vox"),
+        ogt_vox_read_scene_from_file("vox/chr_old.vox", 0),
+        ogt_vox_read_scene_from_file("vox/chr_rain.vox", 0),
+        ogt_vox_read_scene_from_file("vox/chr_sword.vox", 0),
+        ogt_vox_read_scene_from_file("vox/chr_knight.vox", 0),
+        ogt_vox_read_scene_from_file("vox/doom.vox", 0),
+        ogt_vox_read_scene_from_file("vox/test_groups.vox", k_read_scene_flags_groups),
     };
     const uint32_t k_scene_count = sizeof(scenes) / sizeof(scenes[0]);
 
@@ -192,7 +145,7 @@ void demo_merge_scenes()
     ogt_vox_scene* merged_scene = NULL;
     if (use_explicit_output_palette) {
         // this scene controls the explicit output palette of the merged scenes.
-        const ogt_vox_scene* palette_scene = load_vox_scene("merge_src/test_palette_remap.vox");
+        const ogt_vox_scene* palette_scene = ogt_vox_read_scene_from_file("merge_src/test_palette_remap.vox", 0);
         merged_scene = ogt_vox_merge_scenes(scenes, k_scene_count, &palette_scene->palette.color[1], 255);
         ogt_vox_destroy_scene(palette_scene);
     }
@@ -29,6 +29,9 @@
     2. construct a scene from the memory buffer:
        ogt_vox_scene* scene = ogt_vox_read_scene(buffer, buffer_size);
 
+       alternatively, steps 1 and 2 can be done in one go by letting the library map the file into memory:
+       ogt_vox_scene* scene = ogt_vox_read_scene_from_file("file.vox", 0);
+
     3. use the scene members to extract the information you need. eg.
        printf("# of layers: %u\n", scene->num_layers );
 
@@ -56,6 +59,10 @@
         uint8_t* out_buffer = ogt_vox_write_scene(merged_scene, &out_buffer_size);
         // save out_buffer to disk as a .vox file (it has length out_buffer_size)
 
+       or stream it straight to disk without holding the whole file in memory:
+
+        ogt_vox_write_scene_to_file(merged_scene, "merged.vox");
+
     4. destroy the merged scene:
 
         ogt_vox_destroy_scene(merged_scene);
@@ -86,6 +93,11 @@
 
         uint8_t color_index = model->voxel_data[voxel_index];
 
+    If the scene was read with k_read_scene_flags_lazy_models or k_read_scene_flags_sparse_models, use 
+    ogt_vox_get_model_voxels(scene, model_index) to get the voxel data instead, as voxel_data is NULL until 
+    a lazy model has been decoded, and always NULL for a sparse model. Sparse models also provide just their
+    solid voxels via ogt_vox_get_sparse_model.
+
     If color_index == 0, the voxel is not solid and can be skipped,
     If color_index != 0, the voxel is solid and can be used to lookup the color in the palette:
 
@@ -109,6 +121,12 @@
     to an RGB-distance matched color when all 256 colors in the merged
     scene palette has been allocated.
 
+    If many scenes are merged, later scenes can end up with most of their
+    colors remapped that way. Passing k_merge_scene_flags_weighted_palette
+    to ogt_vox_merge_scenes_with_flags instead counts how many voxels use
+    each color across all scenes first, and reduces them to the merged
+    palette so that every scene is treated equally.
+
     You can explicitly control up to 255 merge palette colors by providing 
     those colors to ogt_vox_merge_scenes in the required_colors parameters eg.
 
@@ -125,6 +143,7 @@
     typedef unsigned char uint8_t;
     typedef signed int    int32_t;
     typedef unsigned int  uint32_t;
+    typedef unsigned __int64 uint64_t;
 	#ifndef UINT32_MAX
 		#define UINT32_MAX	((uint32_t)0xFFFFFFFF)
 	#endif
@@ -236,6 +255,24 @@
         const uint8_t* voxel_data;    // grid of voxel data comprising color indices in x -> y -> z order. a color index of 0 means empty, all other indices mean solid and can be used to index the scene's palette to obtain the color for the voxel.
     } ogt_vox_model;
 
+    // a solid voxel within a sparse model.
+    typedef struct ogt_vox_packed_voxel
+    {
+        uint8_t x, y, z;       // position of the voxel within the model
+        uint8_t color_index;   // color index of the voxel. never 0.
+    } ogt_vox_packed_voxel;
+
+    // the sparse form of a model, which only stores its solid voxels. See k_read_scene_flags_sparse_models.
+    typedef struct ogt_vox_sparse_model
+    {
+        uint32_t                    size_x;         // number of voxels in the local x dimension
+        uint32_t                    size_y;         // number of voxels in the local y dimension
+        uint32_t                    size_z;         // number of voxels in the local z dimension
+        uint32_t                    num_voxels;     // number of solid voxels
+        const ogt_vox_packed_voxel* voxels;         // solid voxels in z -> y -> x order, which is the same order they'd appear in voxel_data.
+        const uint32_t*             row_offsets;    // occupancy index. The solid voxels in row (y,z) are voxels[row_offsets[y + z * size_y]] up to but excluding voxels[row_offsets[y + z * size_y + 1]]. size is size_y * size_z + 1
+    } ogt_vox_sparse_model;
+
     // an instance of a model within the scene
     typedef struct ogt_vox_instance
     {
@@ -289,8 +326,25 @@
     void* ogt_vox_malloc(size_t size);
     void  ogt_vox_free(void* mem);
 
+    // a unit of work that the library wants to run. task_data is opaque to the job system and task_index identifies the task.
+    typedef void (*ogt_vox_task_func)(void* task_data, uint32_t task_index);
+
+    // job submit function interface. run task_func(task_data, task_index) on any thread, possibly immediately on the calling thread.
+    typedef void (*ogt_vox_job_submit_func)(ogt_vox_task_func task_func, void* task_data, uint32_t task_index, void* user_data);
+
+    // job wait function interface. blocks until all tasks submitted via the submit function have finished.
+    typedef void (*ogt_vox_job_wait_func)(void* user_data);
+
+    // override the default job system so the library can spread independent work (eg. decoding models) across threads.
+    // By default, or if both functions are NULL, all work runs serially on the calling thread. Output is identical either way.
+    void ogt_vox_set_job_system(ogt_vox_job_submit_func submit_func, ogt_vox_job_wait_func wait_func, void* user_data);
+
     // flags for ogt_vox_read_scene_with_flags
     static const uint32_t k_read_scene_flags_groups = 1 << 0; // if not specified, all instance transforms will be flattened into world space. If specified, will read group information and keep all transforms as local transform relative to the group they are in.
+    static const uint32_t k_read_scene_flags_keep_duplicate_models = 1 << 1; // if not specified, models with identical content are merged into one model that all their instances share. If specified, every model in the file is kept even if it is a duplicate, and this deduplication work is skipped.
+    static const uint32_t k_read_scene_flags_lazy_models = 1 << 2; // if specified, models are not decoded while reading. Each model has NULL voxel_data and zero voxel_hash until first accessed via ogt_vox_get_model_voxels, and refers to its voxels in the source buffer, which must outlive the scene (ogt_vox_read_scene_from_file keeps the file open for you). Duplicate models are then only detected if their packed voxels in the file are byte-identical.
+    static const uint32_t k_read_scene_flags_sparse_models = 1 << 3; // if specified, each model only stores its solid voxels, which are available via ogt_vox_get_sparse_model. voxel_data is always NULL, but ogt_vox_get_model_voxels decodes a dense grid on demand, and voxel_hash is valid. Takes precedence over k_read_scene_flags_lazy_models.
+    static const uint32_t k_read_scene_flags_single_allocation = 1 << 4; // if specified, the scene and all of its models, instances, layers, groups and names are placed in one contiguous allocation. Grids that lazy or sparse models decode on demand are still allocated separately.
 
     // creates a scene from a vox file within a memory buffer of a given size.
     // you can destroy the input buffer once you have the scene as this function will allocate separate memory for the scene objecvt.
@@ -299,16 +353,117 @@
     // just like ogt_vox_read_scene, but you can additionally pass a union of k_read_scene_flags
     const ogt_vox_scene* ogt_vox_read_scene_with_flags(const uint8_t* buffer, uint32_t buffer_size, uint32_t read_flags);
 
+    // a context that keeps the scratch memory used while reading a scene, so that it can be reused by subsequent reads.
+    typedef struct ogt_vox_read_context ogt_vox_read_context;
+
+    // creates and destroys a read context. A context must only be used by one thread at a time.
+    ogt_vox_read_context* ogt_vox_create_read_context();
+    void ogt_vox_destroy_read_context(ogt_vox_read_context* context);
+
+    // just like ogt_vox_read_scene_with_flags, but reuses the scratch memory within context instead of allocating it for every read.
+    const ogt_vox_scene* ogt_vox_read_scene_with_context(ogt_vox_read_context* context, const uint8_t* buffer, uint32_t buffer_size, uint32_t read_flags);
+
+    // just like ogt_vox_read_scene_with_flags, but reads the scene straight from a .vox file on disk. Where the platform supports it, 
+    // the file is memory-mapped read-only and parsed in place, so no intermediate copy of the file is made. Returns NULL if the file 
+    // could not be opened or is not a valid .vox file. Define OGT_VOX_NO_MMAP before the implementation to always use fread instead.
+    const ogt_vox_scene* ogt_vox_read_scene_from_file(const char* filename, uint32_t read_flags);
+
     // destroys a scene object to release its memory.
     void ogt_vox_destroy_scene(const ogt_vox_scene* scene);
 
+    // returns the voxel grid of the specified model, decoding it first if it was read with k_read_scene_flags_lazy_models or
+    // k_read_scene_flags_sparse_models. The first access of such a model writes to it, so it must not happen concurrently with
+    // other accesses to it.
+    const uint8_t* ogt_vox_get_model_voxels(const ogt_vox_scene* scene, uint32_t model_index);
+
+    // returns the sparse form of the specified model if it was read with k_read_scene_flags_sparse_models, or NULL otherwise.
+    const ogt_vox_sparse_model* ogt_vox_get_sparse_model(const ogt_vox_scene* scene, uint32_t model_index);
+
+    // returns the number of non-zero color indices in voxel_data, using SIMD where available.
+    uint32_t ogt_vox_count_solid_voxels(const uint8_t* voxel_data, uint32_t num_voxels);
+
+    // maps the color index of every voxel in the specified model through the 256 entry color_map, and writes the resulting grid
+    // to output, which may be the model's own grid. The grid is obtained via ogt_vox_get_model_voxels, so lazy and sparse models
+    // work too. Uses SIMD byte shuffles where available. voxel_hash is not updated. Returns false if the grid couldn't be decoded.
+    bool ogt_vox_remap_model_colors(const ogt_vox_scene* scene, uint32_t model_index, const uint8_t* color_map, uint8_t* output);
+
+    // callbacks for ogt_vox_visit_chunks. Each one is called as the corresponding chunk is parsed, in file order. Any of them
+    // may be NULL, in which case those chunks are skipped without being parsed. Returning false from a callback stops the walk.
+    // Pointers passed to callbacks are only valid for the duration of the callback. Names longer than 255 characters are truncated.
+    typedef struct ogt_vox_chunk_visitor
+    {
+        void* user_data;    // passed as the first argument of every callback
+        // SIZE: the dimensions of the model in the XYZI chunk that follows.
+        bool (*visit_size)(void* user_data, uint32_t size_x, uint32_t size_y, uint32_t size_z);
+        // XYZI: model_index counts every XYZI chunk so far. packed_voxels points into the buffer and holds num_voxels 4-byte x,y,z,color_index tuples.
+        bool (*visit_xyzi)(void* user_data, uint32_t model_index, const uint8_t* packed_voxels, uint32_t num_voxels);
+        // nTRN: a transform node, with its name (or NULL if it doesn't have one) and the transform of its first frame.
+        bool (*visit_transform_node)(void* user_data, uint32_t node_id, uint32_t child_node_id, uint32_t layer_id, const char* name, bool hidden, const ogt_vox_transform* transform);
+        // nGRP: a group node and the ids of its child nodes.
+        bool (*visit_group_node)(void* user_data, uint32_t node_id, const uint32_t* child_node_ids, uint32_t num_child_nodes);
+        // nSHP: a shape node and the index of the model it refers to.
+        bool (*visit_shape_node)(void* user_data, uint32_t node_id, uint32_t model_index);
+        // LAYR: a layer, with its name (or NULL if it doesn't have one).
+        bool (*visit_layer)(void* user_data, uint32_t layer_id, const char* name, bool hidden);
+        // RGBA: the palette, indexed by the color indices in XYZI chunks. Unlike ogt_vox_scene::palette, it is not reordered by any IMAP chunk.
+        bool (*visit_palette)(void* user_data, const ogt_vox_palette* palette);
+        // IMAP: the display index to palette index map, as stored in the file.
+        bool (*visit_index_map)(void* user_data, const uint8_t* index_map);
+        // MATL: the extended material of a palette entry, as stored in the file.
+        bool (*visit_material)(void* user_data, uint32_t material_index, const ogt_vox_matl* material);
+    } ogt_vox_chunk_visitor;
+
+    // walks the chunks of a vox file within a memory buffer and hands them to the visitor callbacks without creating a scene.
+    // Returns false if the buffer is not a valid .vox file, and true otherwise, including when a callback stopped the walk early.
+    bool ogt_vox_visit_chunks(const uint8_t* buffer, uint32_t buffer_size, const ogt_vox_chunk_visitor* visitor);
+
     // writes the scene to a new buffer and returns the buffer size. free the buffer with ogt_vox_free
     uint8_t* ogt_vox_write_scene(const ogt_vox_scene* scene, uint32_t* buffer_size);
 
+    // returns the exact number of bytes that writing the scene will produce.
+    uint32_t ogt_vox_write_scene_size(const ogt_vox_scene* scene);
+
+    // writes the scene into a caller-provided buffer, eg. one that is reused across many writes or a memory-mapped file.
+    // Returns the number of bytes written, or 0 if the buffer is smaller than ogt_vox_write_scene_size(scene).
+    uint32_t ogt_vox_write_scene_to_buffer(const ogt_vox_scene* scene, uint8_t* buffer, uint32_t buffer_size);
+
+    // write function interface. Called with consecutive pieces of the file being written. Return false to abort writing.
+    typedef bool (*ogt_vox_write_func)(const void* data, uint32_t data_size, void* user_data);
+
+    // writes the scene through write_func in blocks of at most 64KB, so the file is never held in memory all at once.
+    // Returns false if write_func failed.
+    bool ogt_vox_write_scene_to_func(const ogt_vox_scene* scene, ogt_vox_write_func write_func, void* user_data);
+
+    // writes the scene straight to a .vox file on disk in the same way. Returns false if the file could not be written.
+    bool ogt_vox_write_scene_to_file(const ogt_vox_scene* scene, const char* filename);
+
+    // a save session remembers the encoded voxels of each model it saved last time, so that saving a scene again only encodes
+    // the models that changed in between, eg. when autosaving in an editor. Models are matched only by their dimensions and
+    // voxel_hash, without comparing their voxels, so voxel_hash must be updated whenever the voxels of a model change.
+    typedef struct ogt_vox_save_session ogt_vox_save_session;
+
+    // creates and destroys a save session. A session must only be used by one thread at a time.
+    ogt_vox_save_session* ogt_vox_create_save_session();
+    void ogt_vox_destroy_save_session(ogt_vox_save_session* session);
+
+    // just like ogt_vox_write_scene and ogt_vox_write_scene_to_file, but reuse the models that session saved last time.
+    uint8_t* ogt_vox_write_scene_with_session(ogt_vox_save_session* session, const ogt_vox_scene* scene, uint32_t* buffer_size);
+    bool     ogt_vox_write_scene_to_file_with_session(ogt_vox_save_session* session, const ogt_vox_scene* scene, const char* filename);
+
     // merges the specified scenes together to create a bigger scene. Merged scene can be destroyed using ogt_vox_destroy_scene
     // If you require specific colors in the merged scene palette, provide up to and including 255 of them via required_colors/required_color_count.
     ogt_vox_scene* ogt_vox_merge_scenes(const ogt_vox_scene** scenes, uint32_t scene_count, const ogt_vox_rgba* required_colors, const uint32_t required_color_count);
 
+    // flags for ogt_vox_merge_scenes_with_flags
+    static const uint32_t k_merge_scene_flags_weighted_palette = 1 << 0; // if not specified, scene colors are allocated into the merged palette first-come-first-served, and once it is full, colors of later scenes are mapped to the closest color already allocated. If specified, voxels of each color are counted across all scenes up front (in parallel if a job system is set), and if the colors don't all fit, they are reduced to the merged palette with a median cut weighted by those counts. When all colors fit, the merged palette is the same either way.
+
+    static const uint32_t k_merge_scene_flags_keep_duplicate_models = 1 << 1; // if not specified, models that are identical once their colors are remapped to the merged palette are stored once, and all their instances share that model, even across scenes. If specified, every model of every scene is kept, and this deduplication work is skipped.
+
+    static const uint32_t k_merge_scene_flags_share_voxel_data = 1 << 2; // if specified, merged models whose color indices don't change in the merged palette refer to the voxel_data of their source scene instead of a copy of it, so all source scenes must outlive the merged scene. voxel_hash of those source models must be valid. ogt_vox_destroy_scene on the merged scene never frees voxel data it doesn't own.
+
+    // just like ogt_vox_merge_scenes, but you can additionally pass a union of k_merge_scene_flags
+    ogt_vox_scene* ogt_vox_merge_scenes_with_flags(const ogt_vox_scene** scenes, uint32_t scene_count, const ogt_vox_rgba* required_colors, const uint32_t required_color_count, uint32_t merge_flags);
+
 #endif // OGT_VOX_H__
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -320,8 +475,62 @@
 #ifdef OGT_VOX_IMPLEMENTATION
     #include <assert.h>
     #include <stdlib.h>
+    #include <stddef.h>
     #include <string.h>
     #include <stdio.h>
+
+    // platform headers for memory-mapping files in ogt_vox_read_scene_from_file
+    #if !defined(OGT_VOX_NO_MMAP)
+        #if defined(_WIN32)
+            #ifndef WIN32_LEAN_AND_MEAN
+                #define WIN32_LEAN_AND_MEAN
+                #define _VOX_UNDEF_WIN32_LEAN_AND_MEAN
+            #endif
+            #ifndef NOMINMAX
+                #define NOMINMAX
+                #define _VOX_UNDEF_NOMINMAX
+            #endif
+            #include <windows.h>
+            #ifdef _VOX_UNDEF_WIN32_LEAN_AND_MEAN
+                #undef WIN32_LEAN_AND_MEAN
+                #undef _VOX_UNDEF_WIN32_LEAN_AND_MEAN
+            #endif
+            #ifdef _VOX_UNDEF_NOMINMAX
+                #undef NOMINMAX
+                #undef _VOX_UNDEF_NOMINMAX
+            #endif
+            #define _VOX_HAVE_MMAP 1
+        #elif defined(__unix__) || defined(__APPLE__)
+            #include <sys/mman.h>
+            #include <sys/stat.h>
+            #include <fcntl.h>
+            #include <unistd.h>
+            #define _VOX_HAVE_MMAP 1
+        #endif
+    #endif
+
+    // SIMD headers for the solid voxel kernels. Define OGT_VOX_NO_SIMD before the implementation to only use scalar code.
+    #if !defined(OGT_VOX_NO_SIMD)
+        #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+            #include <emmintrin.h>
+            #define _VOX_HAVE_SSE2 1
+            #if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+                #include <immintrin.h>
+                #define _VOX_HAVE_AVX2 1
+                #define _VOX_TARGET_AVX2 __attribute__((target("avx2")))
+            #elif defined(_MSC_VER) && _MSC_VER >= 1800
+                #include <immintrin.h>
+                #define _VOX_HAVE_AVX2 1
+                #define _VOX_TARGET_AVX2
+            #endif
+        #elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+            #include <arm_neon.h>
+            #define _VOX_HAVE_NEON 1
+        #endif
+    #endif
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
     
     // MAKE_VOX_CHUNK_ID: used to construct a literal to describe a chunk in a .vox file.
     #define MAKE_VOX_CHUNK_ID(c0,c1,c2,c3)     ( (c0<<0) | (c1<<8) | (c2<<16) | (c3<<24) )
@@ -384,18 +593,38 @@
         return (a < b) ? a : b; 
     }
 
+    #if defined(_VOX_HAVE_AVX2)
+    // returns true if the cpu and OS support AVX2. The SIMD kernels check this before using their AVX2 versions.
+    static bool _vox_cpu_has_avx2() {
+        static int has_avx2 = -1;   // -1 until the cpu has been checked. _vox_run_tasks checks it first, so tasks only read it.
+        if (has_avx2 < 0) {
+        #if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            bool supported = false;
+            __cpuid(info, 0);
+            if (info[0] >= 7) {
+                // AVX2 also needs the OS to preserve the upper halves of the ymm registers.
+                __cpuid(info, 1);
+                const bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+                __cpuidex(info, 7, 0);
+                supported = os_saves_ymm && (info[1] & (1 << 5));
+            }
+            has_avx2 = supported ? 1 : 0;
+        #else
+            __builtin_cpu_init();
+            has_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+        #endif
+        }
+        return has_avx2 != 0;
+    }
+    #endif
+
     // string utilities
     #ifdef _MSC_VER
-        #define _vox_str_scanf(str,...)      sscanf_s(str,__VA_ARGS__)
-        #define _vox_strcpy_static(dst,src)  strcpy_s(dst,src)
-        #define _vox_strcasecmp(a,b)         _stricmp(a,b)
         #define _vox_strcmp(a,b)             strcmp(a,b)
         #define _vox_strlen(a)               strlen(a)
         #define _vox_sprintf(str,str_max,fmt,...)    sprintf_s(str, str_max, fmt, __VA_ARGS__)
     #else
-        #define _vox_str_scanf(str,...)      sscanf(str,__VA_ARGS__)
-        #define _vox_strcpy_static(dst,src)  strcpy(dst,src)
-        #define _vox_strcasecmp(a,b)         strcasecmp(a,b)
         #define _vox_strcmp(a,b)             strcmp(a,b)
         #define _vox_strlen(a)               strlen(a)
         #define _vox_sprintf(str,str_max,fmt,...)    snprintf(str, str_max, fmt, __VA_ARGS__)        
@@ -416,7 +645,7 @@
     };
 
     static bool _vox_file_read(_vox_file* fp, void* data, uint32_t data_size) {
-        size_t data_to_read = _vox_min(fp->buffer_size - fp->offset, data_size);
+        size_t data_to_read = _vox_min(fp->buffer_size - _vox_min(fp->offset, fp->buffer_size), data_size);
         memcpy(data, &fp->buffer[fp->offset], data_to_read);
         fp->offset += data_size;
         return data_to_read == data_size;
@@ -464,6 +693,45 @@
         }
     }
 
+    // job system utils.
+    static ogt_vox_job_submit_func g_job_submit_func = NULL;    // NULL means tasks are run serially
+    static ogt_vox_job_wait_func   g_job_wait_func   = NULL;
+    static void*                   g_job_user_data   = NULL;
+
+    // set the provided job submit/wait functions if they are non-null, otherwise reset to running tasks serially.
+    void ogt_vox_set_job_system(ogt_vox_job_submit_func submit_func, ogt_vox_job_wait_func wait_func, void* user_data)
+    {
+        assert((submit_func && wait_func) ||      // both submit/wait must be non-NULL -OR-
+            (!submit_func && !wait_func));    // both submit/wait must be NULL. No mixing 'n matching.
+        if (submit_func && wait_func) {
+            g_job_submit_func = submit_func;
+            g_job_wait_func   = wait_func;
+            g_job_user_data   = user_data;
+        }
+        else {
+            g_job_submit_func = NULL;
+            g_job_wait_func   = NULL;
+            g_job_user_data   = NULL;
+        }
+    }
+
+    // runs task_func for every task index in [0, task_count) and returns once they have all finished.
+    static void _vox_run_tasks(ogt_vox_task_func task_func, void* task_data, uint32_t task_count) {
+        if (g_job_submit_func && task_count > 1) {
+        #if defined(_VOX_HAVE_AVX2)
+            // the AVX2 check caches its answer, so make it on this thread before any task can make it concurrently.
+            _vox_cpu_has_avx2();
+        #endif
+            for (uint32_t i = 0; i < task_count; i++)
+                g_job_submit_func(task_func, task_data, i, g_job_user_data);
+            g_job_wait_func(g_job_user_data);
+        }
+        else {
+            for (uint32_t i = 0; i < task_count; i++)
+                task_func(task_data, i);
+        }
+    }
+
     static void* _vox_malloc(size_t size) {
         return size ? g_alloc_func(size) : NULL;
     }
@@ -511,6 +779,8 @@
             capacity = 0;
         }
         void reserve(size_t new_capacity) {
+            if (data && new_capacity <= capacity)
+                return;
             data = (T*)_vox_realloc(data, capacity * sizeof(T), new_capacity * sizeof(T));
             capacity = new_capacity;
         }
@@ -589,66 +859,220 @@
         return r;
     }
 
-    // dictionary utilities
-    static const uint32_t k_vox_max_dict_buffer_size = 4096;
-    static const uint32_t k_vox_max_dict_key_value_pairs = 256;
+    // a string within the source buffer. It is not zero-terminated, and data is NULL if the string is absent.
+    struct _vox_str_view {
+        const char* data;
+        uint32_t    size;
+    };
+
+    // copies a string view into a fixed size buffer as a zero-terminated string, truncating it if necessary.
+    static void _vox_str_view_copy(char* dst, uint32_t dst_size, _vox_str_view src) {
+        uint32_t size = _vox_min(src.size, dst_size - 1);
+        memcpy(dst, src.data, size);
+        dst[size] = 0;
+    }
+
+    static bool _vox_str_view_equals(_vox_str_view view, const char* str) {
+        return view.size == _vox_strlen(str) && memcmp(view.data, str, view.size) == 0;
+    }
+
+    static inline char _vox_tolower(char c) {
+        return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+
+    static inline bool _vox_isspace(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    // parses an integer like atoi does, or like sscanf's %i does if allow_base_prefix is set, advancing the cursor past it.
+    // returns false if there was no integer at the cursor.
+    static bool _vox_parse_int(const char** cursor, const char* end, bool allow_base_prefix, int32_t* value) {
+        const char* c = *cursor;
+        while (c < end && _vox_isspace(*c))
+            c++;
+        bool negative = false;
+        if (c < end && (*c == '-' || *c == '+'))
+            negative = (*c++ == '-');
+        uint32_t base = 10;
+        if (allow_base_prefix && c < end && *c == '0') {
+            base = 8;
+            if (c + 2 < end && (c[1] == 'x' || c[1] == 'X') && ((c[2] >= '0' && c[2] <= '9') || (_vox_tolower(c[2]) >= 'a' && _vox_tolower(c[2]) <= 'f'))) {
+                base = 16;
+                c += 2;
+            }
+        }
+        uint32_t result = 0;
+        const char* first_digit = c;
+        for (; c < end; c++) {
+            char lower = _vox_tolower(*c);
+            uint32_t digit = (lower >= '0' && lower <= '9') ? (uint32_t)(lower - '0') : (lower >= 'a' && lower <= 'f') ? (uint32_t)(lower - 'a' + 10) : 16;
+            if (digit >= base)
+                break;
+            result = result * base + digit;
+        }
+        if (c == first_digit)
+            return false;
+        *value = (int32_t)(negative ? 0u - result : result);
+        *cursor = c;
+        return true;
+    }
+
+    // powers of ten that are exactly representable as a double.
+    static const double k_vox_exact_pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // parses a float with the same result as atof. Plain decimals whose digits fit in a double's mantissa are computed directly
+    // with a single correctly rounded multiply or divide, and anything else falls back to atof on a zero-terminated copy.
+    static float _vox_parse_float(_vox_str_view str) {
+        const char* c   = str.data;
+        const char* end = str.data + str.size;
+        while (c < end && _vox_isspace(*c))
+            c++;
+        bool negative = false;
+        if (c < end && (*c == '-' || *c == '+'))
+            negative = (*c++ == '-');
+        uint64_t mantissa = 0;
+        int32_t  exponent = 0;
+        uint32_t num_digits = 0;
+        bool     exact = true;
+        for (; c < end && *c >= '0' && *c <= '9'; c++, num_digits++) {
+            mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+            exact = exact && mantissa <= ((uint64_t)1 << 53);
+        }
+        if (c < end && *c == '.') {
+            for (c++; c < end && *c >= '0' && *c <= '9'; c++, num_digits++) {
+                mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+                exact = exact && mantissa <= ((uint64_t)1 << 53);
+                exponent--;
+            }
+        }
+        if (num_digits && c < end && (*c == 'e' || *c == 'E')) {
+            const char* exponent_cursor = c + 1;
+            int32_t explicit_exponent = 0;
+            if (exponent_cursor < end && !_vox_isspace(*exponent_cursor) && _vox_parse_int(&exponent_cursor, end, false, &explicit_exponent)) {
+                exact = exact && (exponent_cursor - c) <= 6;    // don't let huge exponents wrap around.
+                exponent += explicit_exponent;
+                c = exponent_cursor;
+            }
+        }
+        // hex floats, infinities and nans are left to atof.
+        exact = exact && num_digits && !(c < end && (*c == 'x' || *c == 'X'));
+        if (exact && exponent >= -22 && exponent <= 22) {
+            double value = (double)mantissa;
+            value = exponent < 0 ? value / k_vox_exact_pow10[-exponent] : value * k_vox_exact_pow10[exponent];
+            return (float)(negative ? -value : value);
+        }
+        char buffer[128];
+        _vox_str_view_copy(buffer, sizeof(buffer), str);
+        return (float)atof(buffer);
+    }
+
+    // the dictionary keys this library understands. Values of any other keys are skipped while reading a dictionary.
+    enum _vox_dict_key {
+        k_vox_dict_key_name,
+        k_vox_dict_key_hidden,
+        k_vox_dict_key_r,
+        k_vox_dict_key_t,
+        k_vox_dict_key_type,
+        k_vox_dict_key_metal,
+        k_vox_dict_key_rough,
+        k_vox_dict_key_spec,
+        k_vox_dict_key_ior,
+        k_vox_dict_key_att,
+        k_vox_dict_key_flux,
+        k_vox_dict_key_emit,
+        k_vox_dict_key_ldr,
+        k_vox_dict_key_trans,
+        k_vox_dict_key_alpha,
+        k_vox_dict_key_d,
+        k_vox_dict_key_sp,
+        k_vox_dict_key_g,
+        k_vox_dict_key_media,
+        k_vox_dict_key_count    // not a known key
+    };
+
+    static const char* k_vox_dict_key_strings[k_vox_dict_key_count] = {
+        "_name", "_hidden", "_r", "_t", "_type", "_metal", "_rough", "_spec", "_ior", "_att",
+        "_flux", "_emit", "_ldr", "_trans", "_alpha", "_d", "_sp", "_g", "_media"
+    };
+
+    // returns which known key the string is, or k_vox_dict_key_count if it isn't one. The length and the first letter after
+    // the underscore pick the only candidate it can be, so at most one key is compared. Keys are case-insensitive.
+    static _vox_dict_key _vox_dict_find_key(_vox_str_view key) {
+        if (key.size < 2 || key.data[0] != '_')
+            return k_vox_dict_key_count;
+        _vox_dict_key candidate = k_vox_dict_key_count;
+        switch (key.size * 256 + (uint8_t)_vox_tolower(key.data[1])) {
+            case 2 * 256 + 'r': candidate = k_vox_dict_key_r;      break;
+            case 2 * 256 + 't': candidate = k_vox_dict_key_t;      break;
+            case 2 * 256 + 'd': candidate = k_vox_dict_key_d;      break;
+            case 2 * 256 + 'g': candidate = k_vox_dict_key_g;      break;
+            case 3 * 256 + 's': candidate = k_vox_dict_key_sp;     break;
+            case 4 * 256 + 'i': candidate = k_vox_dict_key_ior;    break;
+            case 4 * 256 + 'a': candidate = k_vox_dict_key_att;    break;
+            case 4 * 256 + 'l': candidate = k_vox_dict_key_ldr;    break;
+            case 5 * 256 + 'n': candidate = k_vox_dict_key_name;   break;
+            case 5 * 256 + 't': candidate = k_vox_dict_key_type;   break;
+            case 5 * 256 + 's': candidate = k_vox_dict_key_spec;   break;
+            case 5 * 256 + 'f': candidate = k_vox_dict_key_flux;   break;
+            case 5 * 256 + 'e': candidate = k_vox_dict_key_emit;   break;
+            case 6 * 256 + 'm': candidate = _vox_tolower(key.data[3]) == 't' ? k_vox_dict_key_metal : k_vox_dict_key_media; break;
+            case 6 * 256 + 'r': candidate = k_vox_dict_key_rough;  break;
+            case 6 * 256 + 't': candidate = k_vox_dict_key_trans;  break;
+            case 6 * 256 + 'a': candidate = k_vox_dict_key_alpha;  break;
+            case 7 * 256 + 'h': candidate = k_vox_dict_key_hidden; break;
+            default: return k_vox_dict_key_count;
+        }
+        const char* candidate_string = k_vox_dict_key_strings[candidate];
+        for (uint32_t i = 2; i < key.size; i++)
+            if (_vox_tolower(key.data[i]) != candidate_string[i])
+                return k_vox_dict_key_count;
+        return candidate;
+    }
+
+    // the values of the known keys in a dictionary. They point straight into the source buffer.
     struct _vox_dictionary {
-        const char* keys[k_vox_max_dict_key_value_pairs];
-        const char* values[k_vox_max_dict_key_value_pairs];
-        uint32_t    num_key_value_pairs;
-        char        buffer[k_vox_max_dict_buffer_size + 4];    // max 4096, +4 for safety
-        uint32_t    buffer_mem_used;
+        _vox_str_view values[k_vox_dict_key_count];
     };
 
     static bool _vox_file_read_dict(_vox_dictionary * dict, _vox_file * fp) {
+        memset(dict, 0, sizeof(_vox_dictionary));
         uint32_t num_pairs_to_read = 0;
         _vox_file_read(fp, &num_pairs_to_read, sizeof(uint32_t));
-        assert(num_pairs_to_read <= k_vox_max_dict_key_value_pairs);
-
-        dict->buffer_mem_used = 0;
-        dict->num_key_value_pairs = 0;
         for (uint32_t i = 0; i < num_pairs_to_read; i++) {
-            // get the size of the key string
-            uint32_t key_string_size = 0;
-            _vox_file_read(fp, &key_string_size, sizeof(uint32_t));
-            // allocate space for the key, and read it in.
-            if (dict->buffer_mem_used + key_string_size > k_vox_max_dict_buffer_size)
-                return false;
-            char* key = &dict->buffer[dict->buffer_mem_used];
-            dict->buffer_mem_used += key_string_size + 1;    // + 1 for zero terminator
-            _vox_file_read(fp, key, key_string_size);
-            key[key_string_size] = 0;    // zero-terminate
-            assert(_vox_strlen(key) == key_string_size);    // sanity check
-
-            // get the size of the value string
-            uint32_t value_string_size = 0;
-            _vox_file_read(fp, &value_string_size, sizeof(uint32_t));
-            // allocate space for the value, and read it in.
-            if (dict->buffer_mem_used + value_string_size > k_vox_max_dict_buffer_size)
-                return (false);
-            char* value = &dict->buffer[dict->buffer_mem_used];
-            dict->buffer_mem_used += value_string_size + 1;    // + 1 for zero terminator
-            _vox_file_read(fp, value, value_string_size);
-            value[value_string_size] = 0;    // zero-terminate
-            assert(_vox_strlen(value) == value_string_size);    // sanity check
-            // now assign it in the dictionary
-            dict->keys[dict->num_key_value_pairs] = key;
-            dict->values[dict->num_key_value_pairs] = value;
-            dict->num_key_value_pairs++;
+            // read the key and value strings in place, making sure they are within the buffer.
+            _vox_str_view key_value[2];
+            for (uint32_t j = 0; j < 2; j++) {
+                uint32_t string_size = 0;
+                _vox_file_read(fp, &string_size, sizeof(uint32_t));
+                if (_vox_file_eof(fp) || string_size > fp->buffer_size - fp->offset) {
+                    fp->offset = fp->buffer_size;
+                    return false;
+                }
+                key_value[j].data = (const char*)_vox_file_data_pointer(fp);
+                key_value[j].size = string_size;
+                _vox_file_seek_forwards(fp, string_size);
+            }
+            // the first occurrence of a key is the one that counts.
+            _vox_dict_key key = _vox_dict_find_key(key_value[0]);
+            if (key != k_vox_dict_key_count && !dict->values[key].data)
+                dict->values[key] = key_value[1];
         }
-
         return true;
     }
 
-    // helper for looking up in the dictionary
-    static const char* _vox_dict_get_value_as_string(const _vox_dictionary* dict, const char* key_to_find, const char* default_value = NULL) {
-        for (uint32_t i = 0; i < dict->num_key_value_pairs; i++)
-            if (_vox_strcasecmp(dict->keys[i], key_to_find) == 0)
-                return dict->values[i];
-        return default_value;
+    // helpers for looking up in the dictionary
+    static _vox_str_view _vox_dict_get_value(const _vox_dictionary* dict, _vox_dict_key key) {
+        return dict->values[key];
+    }
+
+    static bool _vox_dict_get_value_as_bool(const _vox_dictionary* dict, _vox_dict_key key) {
+        return dict->values[key].size && dict->values[key].data[0] == '1';
     }
 
-    // lookup table for _vox_make_transform_from_dict_strings
+    // lookup table for _vox_make_transform_from_dict
     static const vec3 k_vectors[4] = {
 	vec3_make(1.0f, 0.0f, 0.0f),
 	vec3_make(0.0f, 1.0f, 0.0f),
@@ -656,20 +1080,25 @@
 	vec3_make(0.0f, 0.0f, 0.0f)    // invalid!
     };
 
-    // lookup table for _vox_make_transform_from_dict_strings
+    // lookup table for _vox_make_transform_from_dict
     static const uint32_t k_row2_index[] = { UINT32_MAX, UINT32_MAX, UINT32_MAX, 2, UINT32_MAX, 1, 0, UINT32_MAX };
 
 
-    static ogt_vox_transform _vox_make_transform_from_dict_strings(const char* rotation_string, const char* translation_string) {
+    // makes a transform from the _r and _t values in the frame dictionary of an nTRN chunk.
+    static ogt_vox_transform _vox_make_transform_from_dict(const _vox_dictionary* dict) {
         ogt_vox_transform transform = _vox_transform_identity();
 
-        if (rotation_string != NULL) {
+        _vox_str_view rotation_string = _vox_dict_get_value(dict, k_vox_dict_key_r);
+        if (rotation_string.data != NULL) {
             // compute the per-row indexes into k_vectors[] array.
             // unpack rotation bits. 
             //  bits  : meaning
             //  0 - 1 : index of the non-zero entry in the first row
             //  2 - 3 : index of the non-zero entry in the second row
-            uint32_t packed_rotation_bits = atoi(rotation_string);
+            int32_t rotation_value = 0;
+            const char* cursor = rotation_string.data;
+            _vox_parse_int(&cursor, rotation_string.data + rotation_string.size, false, &rotation_value);
+            uint32_t packed_rotation_bits = (uint32_t)rotation_value;
             uint32_t row0_vec_index = (packed_rotation_bits >> 0) & 3;
             uint32_t row1_vec_index = (packed_rotation_bits >> 2) & 3;
             uint32_t row2_vec_index = k_row2_index[(1 << row0_vec_index) | (1 << row1_vec_index)];    // process of elimination to determine row 2 index based on row0/row1 being one of {0,1,2} choose 2.
@@ -696,11 +1125,15 @@
             transform.m20 = row0.z; transform.m21 = row1.z; transform.m22 = row2.z;
         }
 
-        if (translation_string != NULL) {
+        _vox_str_view translation_string = _vox_dict_get_value(dict, k_vox_dict_key_t);
+        if (translation_string.data != NULL) {
             int32_t x = 0;
             int32_t y = 0;
             int32_t z = 0;
-            _vox_str_scanf(translation_string, "%i %i %i", &x, &y, &z);
+            const char* cursor = translation_string.data;
+            const char* end = translation_string.data + translation_string.size;
+            if (_vox_parse_int(&cursor, end, true, &x) && _vox_parse_int(&cursor, end, true, &y))
+                _vox_parse_int(&cursor, end, true, &z);
             transform.m30 = (float)x;
             transform.m31 = (float)y;
             transform.m32 = (float)z;
@@ -708,6 +1141,55 @@
         return transform;
     }
 
+    // fills in the extended material properties found in the dictionary of a MATL chunk.
+    static void _vox_read_matl_from_dict(const _vox_dictionary* dict, ogt_vox_matl* matl) {
+        _vox_str_view type_string = _vox_dict_get_value(dict, k_vox_dict_key_type);
+        if (type_string.data) {
+            if (_vox_str_view_equals(type_string, "_diffuse")) {
+                matl->type = ogt_matl_type_diffuse;
+            }
+            else if (_vox_str_view_equals(type_string, "_metal")) {
+                matl->type = ogt_matl_type_metal;
+            }
+            else if (_vox_str_view_equals(type_string, "_glass")) {
+                matl->type = ogt_matl_type_glass;
+            }
+            else if (_vox_str_view_equals(type_string, "_emit")) {
+                matl->type = ogt_matl_type_emit;
+            }
+            else if (_vox_str_view_equals(type_string, "_blend")) {
+                matl->type = ogt_matl_type_blend;
+            }
+            else if (_vox_str_view_equals(type_string, "_media")) {
+                matl->type = ogt_matl_type_media;
+            }
+        }
+        // the float properties, in the same order as their content flags.
+        static const struct { _vox_dict_key key; uint32_t content_flag; size_t offset; } k_float_properties[] = {
+            { k_vox_dict_key_metal, k_ogt_vox_matl_have_metal, offsetof(ogt_vox_matl, metal) },
+            { k_vox_dict_key_rough, k_ogt_vox_matl_have_rough, offsetof(ogt_vox_matl, rough) },
+            { k_vox_dict_key_spec,  k_ogt_vox_matl_have_spec,  offsetof(ogt_vox_matl, spec)  },
+            { k_vox_dict_key_ior,   k_ogt_vox_matl_have_ior,   offsetof(ogt_vox_matl, ior)   },
+            { k_vox_dict_key_att,   k_ogt_vox_matl_have_att,   offsetof(ogt_vox_matl, att)   },
+            { k_vox_dict_key_flux,  k_ogt_vox_matl_have_flux,  offsetof(ogt_vox_matl, flux)  },
+            { k_vox_dict_key_emit,  k_ogt_vox_matl_have_emit,  offsetof(ogt_vox_matl, emit)  },
+            { k_vox_dict_key_ldr,   k_ogt_vox_matl_have_ldr,   offsetof(ogt_vox_matl, ldr)   },
+            { k_vox_dict_key_trans, k_ogt_vox_matl_have_trans, offsetof(ogt_vox_matl, trans) },
+            { k_vox_dict_key_alpha, k_ogt_vox_matl_have_alpha, offsetof(ogt_vox_matl, alpha) },
+            { k_vox_dict_key_d,     k_ogt_vox_matl_have_d,     offsetof(ogt_vox_matl, d)     },
+            { k_vox_dict_key_sp,    k_ogt_vox_matl_have_sp,    offsetof(ogt_vox_matl, sp)    },
+            { k_vox_dict_key_g,     k_ogt_vox_matl_have_g,     offsetof(ogt_vox_matl, g)     },
+            { k_vox_dict_key_media, k_ogt_vox_matl_have_media, offsetof(ogt_vox_matl, media) },
+        };
+        for (uint32_t i = 0; i < sizeof(k_float_properties) / sizeof(k_float_properties[0]); i++) {
+            _vox_str_view value = _vox_dict_get_value(dict, k_float_properties[i].key);
+            if (value.data) {
+                matl->content_flags |= k_float_properties[i].content_flag;
+                *(float*)((uint8_t*)matl + k_float_properties[i].offset) = _vox_parse_float(value);
+            }
+        }
+    }
+
     enum _vox_scene_node_type
     {
         k_nodetype_invalid   = 0,    // has not been parsed yet.
@@ -718,10 +1200,12 @@
 
     struct _vox_scene_node_ {
         _vox_scene_node_type node_type;    // only gets assigned when this has been parsed, otherwise will be k_nodetype_invalid
+        uint32_t             node_id;      // the id that other nodes in the file refer to this node by
         union {
             // used only when node_type == k_nodetype_transform
             struct {
-                char              name[64];    // max name size is 64
+                _vox_str_view     name;           // points into the file, or has NULL data if the node has no name
+                uint32_t          name_offset;    // offset of the name within string_data once an instance has used it, otherwise 0
                 ogt_vox_transform transform;
                 uint32_t          child_node_id;
                 uint32_t          layer_id;
@@ -731,6 +1215,7 @@
             struct {
                 uint32_t first_child_node_id_index; // the index of the first child node ID within the ChildNodeID array
                 uint32_t num_child_nodes;           // number of child node IDs starting at the first index
+                bool     on_stack;                  // whether the group is on the group stack while the scene graph is flattened
             } group;
             // used only when node_type == k_nodetype_shape
             struct {
@@ -739,76 +1224,183 @@
         } u;
     };
 
-    static void generate_instances_for_node(
-        const _vox_array<_vox_scene_node_> & nodes, uint32_t node_index, const _vox_array<uint32_t> & child_id_array, uint32_t layer_index,
-        const ogt_vox_transform& transform, const _vox_array<ogt_vox_model*> & model_ptrs, const char* transform_last_name, bool transform_last_hidden,
-        _vox_array<ogt_vox_instance> & instances, _vox_array<char> & string_data, _vox_array<ogt_vox_group>& groups, uint32_t group_index, bool generate_groups)
+    // returns the mask for slot indices of an open-addressed hash table with room for the specified number of entries.
+    static uint32_t _vox_hash_table_mask(size_t num_entries) {
+        uint32_t num_slots = 16;
+        while (num_slots < num_entries * 2)
+            num_slots *= 2;
+        return num_slots - 1;
+    }
+
+    // builds a map from node ids to indices within nodes, so node ids can be sparse without wasting memory. It's an open-addressed
+    // hash table of mask + 1 slots, where each slot holds a node index + 1, or 0 if the slot is empty. Where node ids are
+    // repeated, the last node with that id wins.
+    static void _vox_build_node_map(const _vox_array<_vox_scene_node_>& nodes, uint32_t* node_map, uint32_t mask) {
+        memset(node_map, 0, sizeof(uint32_t) * (mask + 1));
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            uint32_t slot = (nodes[i].node_id * 2654435761u) & mask;
+            while (node_map[slot] && nodes[node_map[slot] - 1].node_id != nodes[i].node_id)
+                slot = (slot + 1) & mask;
+            node_map[slot] = i + 1;
+        }
+    }
+
+    // returns the index within nodes of the node with the specified id, or UINT32_MAX if there isn't one.
+    static uint32_t _vox_find_node(const _vox_array<_vox_scene_node_>& nodes, const uint32_t* node_map, uint32_t mask, uint32_t node_id) {
+        uint32_t slot = (node_id * 2654435761u) & mask;
+        while (node_map[slot]) {
+            if (nodes[node_map[slot] - 1].node_id == node_id)
+                return node_map[slot] - 1;
+            slot = (slot + 1) & mask;
+        }
+        return UINT32_MAX;
+    }
+
+    // returns the offset of the name within string_data, adding it if an identical name isn't already there. name_table is an
+    // open-addressed hash table of mask + 1 slots, where each slot holds the offset of a name within string_data, or 0 if it's empty.
+    static uint32_t _vox_intern_name(_vox_array<char>& string_data, uint32_t* name_table, uint32_t mask, _vox_str_view name) {
+        uint32_t slot = _vox_hash((const uint8_t*)name.data, name.size) & mask;
+        while (name_table[slot]) {
+            const char* existing_name = &string_data[name_table[slot]];
+            if (name_table[slot] + name.size < string_data.size() && memcmp(existing_name, name.data, name.size) == 0 && existing_name[name.size] == 0)
+                return name_table[slot];
+            slot = (slot + 1) & mask;
+        }
+        name_table[slot] = (uint32_t)string_data.size();
+        string_data.push_back_many(name.data, name.size);
+        string_data.push_back(0);    // terminator
+        return name_table[slot];
+    }
+
+    // the state that nodes inherit from their parents while the scene graph is flattened.
+    struct _vox_node_state {
+        ogt_vox_transform transform;
+        uint32_t          layer_index;
+        uint32_t          group_index;
+        uint32_t          name_node_index;    // index of the closest named transform node above, or UINT32_MAX if there is none
+        bool              hidden;
+    };
+
+    // a group node whose children are still being visited while the scene graph is flattened.
+    struct _vox_group_frame {
+        uint32_t        node_index;
+        uint32_t        next_child;    // index of the next child node to visit within the group's child node IDs
+        _vox_node_state child_state;   // the state that all children of the group inherit
+    };
+
+    // walks the scene graph from the root node in depth-first order, generating instances for shape nodes, and groups for group
+    // nodes if generate_groups is set. Chains of transform nodes are followed in a loop and only group nodes are pushed onto
+    // group_stack, so memory use is bounded by the depth of the graph rather than the number of nodes, and deep graphs can't
+    // overflow the call stack. Instance names are interned, so each distinct name is only stored in string_data once.
+    // scratch holds the node map and the name table.
+    static void _vox_generate_instances(
+        _vox_array<_vox_scene_node_>& nodes, const _vox_array<uint32_t>& child_id_array, const _vox_array<ogt_vox_model*>& model_ptrs,
+        bool generate_groups, _vox_array<uint32_t>& scratch, _vox_array<_vox_group_frame>& group_stack,
+        _vox_array<ogt_vox_instance>& instances, _vox_array<char>& string_data, _vox_array<ogt_vox_group>& groups)
     {
-        const _vox_scene_node_* node = &nodes[node_index];
-        assert(node);
-        switch (node->node_type) 
-        {
-            case k_nodetype_transform: 
-            {
-                ogt_vox_transform new_transform = (generate_groups) ? node->u.transform.transform  // don't multiply by the parent transform. caller wants the group-relative transform
-                        : _vox_transform_multiply(node->u.transform.transform, transform);         // flatten the transform if we're not generating groups: child transform * parent transform
-                const char* new_transform_name = node->u.transform.name[0] ? node->u.transform.name : NULL;
-                transform_last_name = new_transform_name ? new_transform_name : transform_last_name;    // if this node has a name, use it instead of our parent name
-                generate_instances_for_node(nodes, node->u.transform.child_node_id, child_id_array, node->u.transform.layer_id, new_transform, model_ptrs, transform_last_name, node->u.transform.hidden, instances, string_data, groups, group_index, generate_groups);
-                break;
-            }
-            case k_nodetype_group: 
-            {
-                // create a new group only if we're generating groups.
-                uint32_t next_group_index = 0;
-                if (generate_groups) {
-                    next_group_index = (uint32_t)groups.size();
-                    ogt_vox_group group;
-                    group.parent_group_index = group_index;
-                    group.transform          = transform;
-                    group.hidden             = transform_last_hidden;
-                    group.layer_index        = layer_index;
-                    groups.push_back(group);
+        uint32_t num_named_nodes = 0;
+        for (uint32_t i = 0; i < nodes.size(); i++)
+            num_named_nodes += (nodes[i].node_type == k_nodetype_transform && nodes[i].u.transform.name.size) ? 1 : 0;
+        const uint32_t node_map_mask   = _vox_hash_table_mask(nodes.size());
+        const uint32_t name_table_mask = _vox_hash_table_mask(num_named_nodes);
+        scratch.resize((node_map_mask + 1) + (name_table_mask + 1));
+        uint32_t* node_map   = &scratch[0];
+        uint32_t* name_table = &scratch[node_map_mask + 1];
+        _vox_build_node_map(nodes, node_map, node_map_mask);
+        memset(name_table, 0, sizeof(uint32_t) * (name_table_mask + 1));
+        group_stack.resize(0);
+
+        _vox_node_state state;
+        state.transform       = _vox_transform_identity();
+        state.layer_index     = 0;
+        state.group_index     = k_invalid_group_index;
+        state.name_node_index = UINT32_MAX;
+        state.hidden          = false;
+        uint32_t node_id = 0;    // the root node
+        for (;;) {
+            // follow transform nodes down until we reach a group or shape node. A chain of transforms longer than the number of
+            // nodes can only be a cycle in a malformed file, so we stop there.
+            for (size_t depth = group_stack.size(); depth <= nodes.size(); depth++) {
+                const uint32_t node_index = _vox_find_node(nodes, node_map, node_map_mask, node_id);
+                assert(node_index != UINT32_MAX);    // referenced node doesn't exist!
+                if (node_index == UINT32_MAX)
+                    break;
+                const _vox_scene_node_* node = &nodes[node_index];
+                if (node->node_type == k_nodetype_transform) {
+                    state.transform = (generate_groups) ? node->u.transform.transform       // don't multiply by the parent transform. caller wants the group-relative transform
+                        : _vox_transform_multiply(node->u.transform.transform, state.transform); // flatten the transform if we're not generating groups: child transform * parent transform
+                    if (node->u.transform.name.size && node->u.transform.name.data[0])
+                        state.name_node_index = node_index;    // if this node has a name, use it instead of our parent name
+                    state.layer_index = node->u.transform.layer_id;
+                    state.hidden      = node->u.transform.hidden;
+                    node_id = node->u.transform.child_node_id;
+                    continue;
                 }
-                // child nodes will only be hidden if their immediate transform is hidden.
-                transform_last_hidden = false;
-
-                const uint32_t* child_node_ids = (const uint32_t*)& child_id_array[node->u.group.first_child_node_id_index];
-                for (uint32_t i = 0; i < node->u.group.num_child_nodes; i++) {
-                    generate_instances_for_node(nodes, child_node_ids[i], child_id_array, layer_index, transform, model_ptrs, transform_last_name, transform_last_hidden, instances, string_data, groups, next_group_index, generate_groups);
+                if (node->node_type == k_nodetype_group) {
+                    // a group that is already on the stack is its own ancestor, which can only be a cycle in a malformed file.
+                    if (node->u.group.on_stack)
+                        break;
+                    // create a new group only if we're generating groups.
+                    _vox_group_frame frame;
+                    frame.node_index  = node_index;
+                    frame.next_child  = 0;
+                    frame.child_state = state;
+                    frame.child_state.group_index = 0;
+                    if (generate_groups) {
+                        frame.child_state.group_index = (uint32_t)groups.size();
+                        ogt_vox_group group;
+                        group.parent_group_index = state.group_index;
+                        group.transform          = state.transform;
+                        group.hidden             = state.hidden;
+                        group.layer_index        = state.layer_index;
+                        groups.push_back(group);
+                    }
+                    // child nodes will only be hidden if their immediate transform is hidden.
+                    frame.child_state.hidden = false;
+                    nodes[node_index].u.group.on_stack = true;
+                    group_stack.push_back(frame);
                 }
-                break;
-            }
-            case k_nodetype_shape: 
-            {
-                assert(node->u.shape.model_id < model_ptrs.size());
-                if (node->u.shape.model_id < model_ptrs.size() &&    // model ID is valid
-                    model_ptrs[node->u.shape.model_id] != NULL )     // model is non-NULL.   
-                {
-                    assert(generate_groups || group_index == 0);     // if we're not generating groups, group_index should be zero to map to the root group.
-                    ogt_vox_instance new_instance;
-                    new_instance.model_index = node->u.shape.model_id;
-                    new_instance.transform   = transform;
-                    new_instance.layer_index = layer_index;
-                    new_instance.group_index = group_index;
-                    new_instance.hidden      = transform_last_hidden;
-                    // if we got a transform name, allocate space in string_data for it and keep track of the index 
-                    // within string data. This will be patched to a real pointer at the very end.
-                    new_instance.name = 0;
-                    if (transform_last_name && transform_last_name[0]) {
-                        new_instance.name = (const char*)(string_data.size());
-                        size_t name_size = _vox_strlen(transform_last_name) + 1;       // +1 for terminator
-                        string_data.push_back_many(transform_last_name, name_size);
+                else if (node->node_type == k_nodetype_shape) {
+                    assert(node->u.shape.model_id < model_ptrs.size());
+                    if (node->u.shape.model_id < model_ptrs.size() &&    // model ID is valid
+                        model_ptrs[node->u.shape.model_id] != NULL )     // model is non-NULL.
+                    {
+                        assert(generate_groups || state.group_index == 0);     // if we're not generating groups, group_index should be zero to map to the root group.
+                        ogt_vox_instance new_instance;
+                        new_instance.model_index = node->u.shape.model_id;
+                        new_instance.transform   = state.transform;
+                        new_instance.layer_index = state.layer_index;
+                        new_instance.group_index = state.group_index;
+                        new_instance.hidden      = state.hidden;
+                        // if we got a transform name, intern it in string_data and keep track of its offset within
+                        // string data. This will be patched to a real pointer at the very end.
+                        new_instance.name = 0;
+                        if (state.name_node_index != UINT32_MAX) {
+                            _vox_scene_node_* name_node = &nodes[state.name_node_index];
+                            if (!name_node->u.transform.name_offset)
+                                name_node->u.transform.name_offset = _vox_intern_name(string_data, name_table, name_table_mask, name_node->u.transform.name);
+                            new_instance.name = (const char*)(size_t)name_node->u.transform.name_offset;
+                        }
+                        // create the instance
+                        instances.push_back(new_instance);
                     }
-                    // create the instance
-                    instances.push_back(new_instance);
+                }
+                else {
+                    assert(0); // unhandled node type!
                 }
                 break;
             }
-            default:
-            {
-                assert(0); // unhandled node type!
+
+            // move on to the next child of the innermost group that still has children left to visit.
+            while (group_stack.size() && group_stack[group_stack.size() - 1].next_child == nodes[group_stack[group_stack.size() - 1].node_index].u.group.num_child_nodes) {
+                nodes[group_stack[group_stack.size() - 1].node_index].u.group.on_stack = false;
+                group_stack.resize(group_stack.size() - 1);
             }
+            if (!group_stack.size())
+                break;
+            _vox_group_frame* frame = &group_stack[group_stack.size() - 1];
+            node_id = child_id_array[nodes[frame->node_index].u.group.first_child_node_id_index + frame->next_child++];
+            state   = frame->child_state;
         }
     }
 
@@ -820,34 +1412,530 @@
                lhs->model_index > rhs->model_index ?  1 : 0;
     }
     
+    // a read-only view of a whole file on disk. It is either memory-mapped or loaded into a heap buffer.
+    struct _vox_mapped_file {
+        const uint8_t* data;        // contents of the file
+        uint32_t       size;        // size of the file in bytes
+        bool           is_mapped;   // true if data is a memory-mapped view, false if it was allocated via _vox_malloc
+    };
+
+    // library-private state that is part of every scene allocation this library makes, directly after the ogt_vox_scene.
+    // Scenes built by the caller don't have it, so it is only accessed from functions that take a scene this library made.
+    struct _vox_scene_internal {
+        uint32_t         read_flags;          // k_read_scene_flags_* that the scene was read with
+        uint8_t          color_remap[256];    // maps color indices in the file to color indices in the scene palette
+        _vox_mapped_file mapped_file;         // file owned by the scene that lazy models refer to. data is NULL if there is none.
+    };
+
+    static _vox_scene_internal* _vox_get_scene_internal(const ogt_vox_scene* scene) {
+        return (_vox_scene_internal*)const_cast<ogt_vox_scene*>(&scene[1]);
+    }
+
+    // location of the packed voxels of an XYZI chunk, recorded while parsing so the model can be decoded later.
+    // models read with k_read_scene_flags_lazy_models or k_read_scene_flags_sparse_models store this directly after 
+    // their ogt_vox_model. For sparse models it refers to the model's own sorted voxels, followed by the ogt_vox_sparse_model.
+    // Only those models are created without voxel_data, so a model without voxel_data always has one of these after it.
+    struct _vox_xyzi_chunk {
+        ogt_vox_model* model;            // model to decode into. Its grid is allocated but not yet initialized.
+        const uint8_t* packed_voxels;    // packed (x,y,z,color_index) voxels within the source buffer
+        uint32_t       num_voxels;       // number of packed voxels
+        uint32_t       tag;              // k_vox_xyzi_chunk_tag_* if stored after a model, 0 otherwise.
+        const uint8_t* color_remap;      // if non-NULL, applied to the voxels after the model has been hashed. Used by lazy models.
+        uint8_t*       sparse_grid;      // dense grid of a sparse model, decoded on demand. Sparse models keep voxel_data NULL.
+    };
+
+    // tags of the _vox_xyzi_chunk stored after lazy and sparse models.
+    static const uint32_t k_vox_xyzi_chunk_tag_lazy   = MAKE_VOX_CHUNK_ID('l','a','z','y');
+    static const uint32_t k_vox_xyzi_chunk_tag_sparse = MAKE_VOX_CHUNK_ID('s','p','r','s');
+
+    // returns the chunk stored after a lazy or sparse model. Must only be called for models without voxel_data.
+    static _vox_xyzi_chunk* _vox_get_model_chunk(const ogt_vox_model* model) {
+        assert(!model->voxel_data);
+        _vox_xyzi_chunk* chunk = (_vox_xyzi_chunk*)const_cast<ogt_vox_model*>(&model[1]);
+        assert(chunk->tag == k_vox_xyzi_chunk_tag_lazy || chunk->tag == k_vox_xyzi_chunk_tag_sparse);
+        return chunk;
+    }
+
     // returns true if the 2 models are content-wise identical.
     static bool _vox_models_are_equal(const ogt_vox_model* lhs, const ogt_vox_model* rhs) {
         // early out: if hashes don't match, they can't be equal
         // if hashes match, they might be equal OR there might be a hash collision.
         if (lhs->voxel_hash != rhs->voxel_hash)
             return false;
-        // early out: if number of voxels in the model's grid don't match, they can't be equal.
-        uint32_t num_voxels_lhs = lhs->size_x * lhs->size_y * lhs->size_z;
-        uint32_t num_voxels_rhs = rhs->size_x * rhs->size_y * rhs->size_z;
-        if (num_voxels_lhs != num_voxels_rhs)
+        // early out: if the model's grid dimensions don't match, they can't be equal.
+        if (lhs->size_x != rhs->size_x || lhs->size_y != rhs->size_y || lhs->size_z != rhs->size_z)
             return false;
+        // models that have not been decoded yet are only equal if their packed voxel data is identical.
+        if (!lhs->voxel_data || !rhs->voxel_data) {
+            if (lhs->voxel_data || rhs->voxel_data)
+                return false;
+            const _vox_xyzi_chunk* lhs_chunk = _vox_get_model_chunk(lhs);
+            const _vox_xyzi_chunk* rhs_chunk = _vox_get_model_chunk(rhs);
+            return lhs_chunk->num_voxels == rhs_chunk->num_voxels &&
+                memcmp(lhs_chunk->packed_voxels, rhs_chunk->packed_voxels, lhs_chunk->num_voxels * 4) == 0;
+        }
         // Finally, we know their hashes are the same, and their dimensions are the same
         // but they are only equal if they have exactly the same voxel data.
-        return memcmp(lhs->voxel_data, rhs->voxel_data, num_voxels_lhs) == 0 ? true : false;
+        uint32_t num_voxels = lhs->size_x * lhs->size_y * lhs->size_z;
+        return memcmp(lhs->voxel_data, rhs->voxel_data, num_voxels) == 0 ? true : false;
+    }
+
+    // combines the content hash and the dimensions of a model into a key for looking up models in a hash table.
+    static uint32_t _vox_model_table_hash(const ogt_vox_model* model) {
+        // models that have not been decoded yet have no content hash, so use their number of voxels instead.
+        uint32_t hash = model->voxel_data ? model->voxel_hash : _vox_get_model_chunk(model)->num_voxels;
+        hash = (hash * 65559) + model->size_x;
+        hash = (hash * 65559) + model->size_y;
+        hash = (hash * 65559) + model->size_z;
+        // mix the high bits down so that masking the hash to a table index uses all of it.
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        return hash;
+    }
+
+    // looks up models[model_index] in an open-addressed hash table of model indices keyed on content hash and dimensions,
+    // where empty buckets hold UINT32_MAX. Returns the index of an identical model already in the table, or adds the model
+    // to the table and returns model_index if there isn't one.
+    static uint32_t _vox_find_or_add_model_in_table(uint32_t* table, uint32_t table_mask, ogt_vox_model* const* models, uint32_t model_index) {
+        const ogt_vox_model* model = models[model_index];
+        uint32_t bucket_index = _vox_model_table_hash(model) & table_mask;
+        for (uint32_t probe_count = 0; probe_count <= table_mask; probe_count++) {
+            uint32_t existing_index = table[bucket_index];
+            // if we found an empty bucket, this model is unique so far. Add it to the table.
+            if (existing_index == UINT32_MAX) {
+                table[bucket_index] = model_index;
+                return model_index;
+            }
+            if (_vox_models_are_equal(models[existing_index], model))
+                return existing_index;
+            // use quadratic probing to find the next bucket in the case of a collision.
+            bucket_index = (bucket_index + probe_count + 1) & table_mask;
+        }
+        assert(0); // the table should never be full.
+        return model_index;
+    }
+
+    // finds models that are content-wise identical to an earlier model in model_ptrs using a hash table keyed on 
+    // their content hash and dimensions. Duplicates are freed leaving NULL gaps in the model_ptrs array, and all 
+    // instances are remapped in a single pass so they refer to the earliest of the identical models. Duplicates that
+    // live within a scene arena are not freed. scratch provides the memory for the hash table and remap table.
+    static void _vox_remove_duplicate_models(_vox_array<ogt_vox_model*>& model_ptrs, _vox_array<ogt_vox_instance>& instances, bool free_duplicates, _vox_array<uint32_t>& scratch) {
+        uint32_t num_models = (uint32_t)model_ptrs.size();
+        if (num_models < 2)
+            return;
+
+        // allocate a hash table that is sized at the next power of 2 above twice the model count
+        uint32_t table_size = 1;
+        while (table_size < num_models * 2)
+            table_size *= 2;
+        uint32_t  table_mask  = table_size - 1;
+        scratch.resize(table_size + num_models);
+        uint32_t* table       = &scratch[0];
+        uint32_t* model_remap = &scratch[table_size];
+        memset(table, -1, sizeof(uint32_t) * table_size);
+
+        bool found_duplicate = false;
+        for (uint32_t i = 0; i < num_models; i++) {
+            model_remap[i] = i;
+            ogt_vox_model* model = model_ptrs[i];
+            if (!model)
+                continue;
+            uint32_t existing_index = _vox_find_or_add_model_in_table(table, table_mask, &model_ptrs[0], i);
+            // model i is the same as an earlier model, so free model i and keep the earlier one.
+            if (existing_index != i) {
+                if (free_duplicates)
+                    _vox_free(model);
+                model_ptrs[i]   = NULL;
+                model_remap[i]  = existing_index;
+                found_duplicate = true;
+            }
+        }
+
+        // remap all instances that were referring to a duplicate model to now refer to the model we kept.
+        if (found_duplicate) {
+            for (uint32_t i = 0; i < instances.size(); i++)
+                instances[i].model_index = model_remap[instances[i].model_index];
+        }
+    }
+
+    // state shared by all model decoding tasks. Task i decodes chunks[task_first_chunk[i]] up to chunks[task_first_chunk[i+1]].
+    struct _vox_decode_models_task_data {
+        const _vox_xyzi_chunk* chunks;
+        const uint32_t*        task_first_chunk;
+        const uint8_t*         color_remap;     // if non-NULL, applied to every voxel after the model has been hashed.
+    };
+
+    static ogt_vox_sparse_model* _vox_get_sparse_model(const ogt_vox_model* model) {
+        return (ogt_vox_sparse_model*)const_cast<_vox_xyzi_chunk*>(&((const _vox_xyzi_chunk*)&model[1])[1]);
+    }
+
+    // number of bytes needed after the ogt_vox_model for a sparse model with up to the specified number of voxels.
+    static size_t _vox_sparse_model_extra_size(uint32_t size_y, uint32_t size_z, uint32_t max_voxels) {
+        return sizeof(_vox_xyzi_chunk) + sizeof(ogt_vox_sparse_model) + sizeof(uint32_t) * (size_y * size_z + 1) + sizeof(ogt_vox_packed_voxel) * max_voxels;
+    }
+
+    // returns base raised to the power exp, with the same wrap-around as the arithmetic in _vox_hash
+    static uint32_t _vox_pow(uint32_t base, uint32_t exp) {
+        uint32_t result = 1;
+        while (exp) {
+            if (exp & 1)
+                result *= base;
+            base *= base;
+            exp >>= 1;
+        }
+        return result;
+    }
+
+    // builds the sparse form of a model from packed voxels in the file. The voxels are sorted into the same order as a dense
+    // grid, and where a position is written more than once the last write wins, just like when decoding to a dense grid.
+    static void _vox_build_sparse_model(const _vox_xyzi_chunk* chunk, const uint8_t* color_remap) {
+        ogt_vox_model* model = chunk->model;
+        const uint32_t size_x = model->size_x;
+        const uint32_t size_y = model->size_y;
+        const uint32_t size_z = model->size_z;
+        const uint32_t num_rows = size_y * size_z;
+        ogt_vox_sparse_model* sparse_model = _vox_get_sparse_model(model);
+        uint32_t* row_offsets = (uint32_t*)&sparse_model[1];
+        ogt_vox_packed_voxel* voxels = (ogt_vox_packed_voxel*)&row_offsets[num_rows + 1];
+
+        // counting sort the voxels into rows: count voxels in each row, turn counts into offsets and then scatter.
+        memset(row_offsets, 0, sizeof(uint32_t) * (num_rows + 1));
+        const ogt_vox_packed_voxel* packed_voxels = (const ogt_vox_packed_voxel*)chunk->packed_voxels;
+        for (uint32_t i = 0; i < chunk->num_voxels; i++) {
+            const ogt_vox_packed_voxel& voxel = packed_voxels[i];
+            assert(voxel.x < size_x && voxel.y < size_y && voxel.z < size_z);
+            if (voxel.x < size_x && voxel.y < size_y && voxel.z < size_z)
+                row_offsets[voxel.y + voxel.z * size_y + 1]++;
+        }
+        for (uint32_t row = 0; row < num_rows; row++)
+            row_offsets[row + 1] += row_offsets[row];
+        for (uint32_t i = 0; i < chunk->num_voxels; i++) {
+            const ogt_vox_packed_voxel& voxel = packed_voxels[i];
+            if (voxel.x < size_x && voxel.y < size_y && voxel.z < size_z)
+                voxels[row_offsets[voxel.y + voxel.z * size_y]++] = voxel;
+        }
+        // scattering advanced each row offset to the start of the next row, so shift them back.
+        for (uint32_t row = num_rows; row > 0; row--)
+            row_offsets[row] = row_offsets[row - 1];
+        row_offsets[0] = 0;
+
+        // now sort each row on x, and compact it down so it only contains the last write to each solid voxel. 
+        // We also hash the voxels as if they were a dense grid here, so the hash matches a densely decoded model.
+        const uint32_t k_hash_prime = 65559;
+        uint32_t hash = 0;
+        uint32_t next_hash_index = 0;
+        uint32_t num_voxels = 0;
+        for (uint32_t row = 0; row < num_rows; row++) {
+            uint32_t row_begin = row_offsets[row];
+            uint32_t row_end   = row_offsets[row + 1];
+            row_offsets[row] = num_voxels;
+            // rows are short and usually already sorted, so a stable insertion sort is a good fit.
+            for (uint32_t i = row_begin + 1; i < row_end; i++) {
+                ogt_vox_packed_voxel voxel = voxels[i];
+                uint32_t j = i;
+                for (; j > row_begin && voxels[j - 1].x > voxel.x; j--)
+                    voxels[j] = voxels[j - 1];
+                voxels[j] = voxel;
+            }
+            for (uint32_t i = row_begin; i < row_end; i++) {
+                // skip voxels that are overwritten by a later voxel at the same position, and empty voxels.
+                if ((i + 1 < row_end && voxels[i + 1].x == voxels[i].x) || voxels[i].color_index == 0)
+                    continue;
+                ogt_vox_packed_voxel voxel = voxels[i];
+                uint32_t hash_index = voxel.x + row * size_x;
+                hash = voxel.color_index + (hash * _vox_pow(k_hash_prime, hash_index - next_hash_index) * k_hash_prime);
+                next_hash_index = hash_index + 1;
+                if (color_remap)
+                    voxel.color_index = color_remap[voxel.color_index];
+                voxels[num_voxels++] = voxel;
+            }
+        }
+        row_offsets[num_rows] = num_voxels;
+        hash *= _vox_pow(k_hash_prime, size_x * num_rows - next_hash_index);
+
+        model->voxel_hash = hash;
+        sparse_model->size_x      = size_x;
+        sparse_model->size_y      = size_y;
+        sparse_model->size_z      = size_z;
+        sparse_model->num_voxels  = num_voxels;
+        sparse_model->voxels      = voxels;
+        sparse_model->row_offsets = row_offsets;
+        // point the model's chunk at its own sorted voxels so they can be decoded into a dense grid on demand.
+        _vox_xyzi_chunk* model_chunk = (_vox_xyzi_chunk*)&model[1];
+        model_chunk->model         = model;
+        model_chunk->packed_voxels = (const uint8_t*)voxels;
+        model_chunk->num_voxels    = num_voxels;
+        model_chunk->tag           = k_vox_xyzi_chunk_tag_sparse;
+        model_chunk->color_remap   = NULL;
+        model_chunk->sparse_grid   = NULL;
+    }
+
+    // allocates an array for a scene, either from the scene arena if there is one, or separately otherwise.
+    static void* _vox_scene_array_alloc(uint8_t*& arena_cursor, size_t size) {
+        if (!arena_cursor)
+            return _vox_malloc(size);
+        void* array = arena_cursor;
+        arena_cursor += (size + 7) & ~(size_t)7;
+        return array;
+    }
+
+    // remaps num_voxels color indices from src to dst through the 256 entry color_map. dst may be the same as src. Spans of
+    // empty voxels are filled 16 or 32 at a time, and other spans are looked up with byte shuffles where SIMD is available.
+    static void _vox_remap_colors_scalar(const uint8_t* color_map, const uint8_t* src, uint8_t* dst, uint32_t num_voxels) {
+        for (uint32_t i = 0; i < num_voxels; i++)
+            dst[i] = color_map[src[i]];
+    }
+
+    #if defined(_VOX_HAVE_SSE2)
+    static void _vox_remap_colors_sse2(const uint8_t* color_map, const uint8_t* src, uint8_t* dst, uint32_t num_voxels) {
+        const __m128i zero        = _mm_setzero_si128();
+        const __m128i empty_color = _mm_set1_epi8((char)color_map[0]);
+        uint32_t i = 0;
+        for (; i + 16 <= num_voxels; i += 16) {
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&src[i]), zero)) == 0xFFFF)
+                _mm_storeu_si128((__m128i*)&dst[i], empty_color);
+            else
+                _vox_remap_colors_scalar(color_map, &src[i], &dst[i], 16);
+        }
+        _vox_remap_colors_scalar(color_map, &src[i], &dst[i], num_voxels - i);
+    }
+    #endif
+
+    #if defined(_VOX_HAVE_AVX2)
+    // splits the color map into 16 rows of 16 entries, and looks up each color index in every row with a byte shuffle that
+    // only outputs anything for the indices within that row.
+    _VOX_TARGET_AVX2 static void _vox_remap_colors_avx2(const uint8_t* color_map, const uint8_t* src, uint8_t* dst, uint32_t num_voxels) {
+        const __m256i zero        = _mm256_setzero_si256();
+        const __m256i outside_row = _mm256_set1_epi8(0x70);
+        const __m256i row_size    = _mm256_set1_epi8(16);
+        const __m256i empty_color = _mm256_set1_epi8((char)color_map[0]);
+        __m256i rows[16];
+        for (uint32_t row = 0; row < 16; row++)
+            rows[row] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&color_map[row * 16]));
+        uint32_t i = 0;
+        for (; i + 32 <= num_voxels; i += 32) {
+            __m256i color_indices = _mm256_loadu_si256((const __m256i*)&src[i]);
+            if ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(color_indices, zero)) == 0xFFFFFFFF) {
+                _mm256_storeu_si256((__m256i*)&dst[i], empty_color);
+                continue;
+            }
+            // subtracting 16 for each row leaves indices below 16 just for the current row. A saturating add then sets the top
+            // bit of every other index, which makes the shuffle output 0 for them.
+            __m256i remapped = zero;
+            for (uint32_t row = 0; row < 16; row++) {
+                __m256i row_indices = _mm256_adds_epu8(color_indices, outside_row);
+                remapped = _mm256_or_si256(remapped, _mm256_shuffle_epi8(rows[row], row_indices));
+                color_indices = _mm256_sub_epi8(color_indices, row_size);
+            }
+            _mm256_storeu_si256((__m256i*)&dst[i], remapped);
+        }
+        _vox_remap_colors_sse2(color_map, &src[i], &dst[i], num_voxels - i);
+    }
+    #endif
+
+    #if defined(_VOX_HAVE_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    // looks up each color index in four 64 entry tables. Indices that are out of range for a table leave the result as it is.
+    static void _vox_remap_colors_neon(const uint8_t* color_map, const uint8_t* src, uint8_t* dst, uint32_t num_voxels) {
+        uint8x16x4_t tables[4];
+        for (uint32_t table = 0; table < 4; table++)
+            for (uint32_t row = 0; row < 4; row++)
+                tables[table].val[row] = vld1q_u8(&color_map[table * 64 + row * 16]);
+        const uint8x16_t table_size = vdupq_n_u8(64);
+        uint32_t i = 0;
+        for (; i + 16 <= num_voxels; i += 16) {
+            uint8x16_t color_indices = vld1q_u8(&src[i]);
+            uint8x16_t remapped = vqtbl4q_u8(tables[0], color_indices);
+            for (uint32_t table = 1; table < 4; table++) {
+                color_indices = vsubq_u8(color_indices, table_size);
+                remapped = vqtbx4q_u8(remapped, tables[table], color_indices);
+            }
+            vst1q_u8(&dst[i], remapped);
+        }
+        _vox_remap_colors_scalar(color_map, &src[i], &dst[i], num_voxels - i);
+    }
+    #define _VOX_HAVE_NEON_REMAP 1
+    #endif
+
+    static void _vox_remap_colors(const uint8_t* color_map, const uint8_t* src, uint8_t* dst, uint32_t num_voxels) {
+    #if defined(_VOX_HAVE_AVX2)
+        if (_vox_cpu_has_avx2()) {
+            _vox_remap_colors_avx2(color_map, src, dst, num_voxels);
+            return;
+        }
+    #endif
+    #if defined(_VOX_HAVE_SSE2)
+        _vox_remap_colors_sse2(color_map, src, dst, num_voxels);
+    #elif defined(_VOX_HAVE_NEON_REMAP)
+        _vox_remap_colors_neon(color_map, src, dst, num_voxels);
+    #else
+        _vox_remap_colors_scalar(color_map, src, dst, num_voxels);
+    #endif
+    }
+
+    bool ogt_vox_remap_model_colors(const ogt_vox_scene* scene, uint32_t model_index, const uint8_t* color_map, uint8_t* output) {
+        const uint8_t* voxel_data = ogt_vox_get_model_voxels(scene, model_index);
+        if (!voxel_data)
+            return false;
+        const ogt_vox_model* model = scene->models[model_index];
+        _vox_remap_colors(color_map, voxel_data, output, model->size_x * model->size_y * model->size_z);
+        return true;
+    }
+
+    // minimum number of grid voxels that a single decoding task will process, so tiny models get batched together.
+    static const uint32_t k_vox_min_voxels_per_decode_task = 64 * 1024;
+
+    // scatters the packed voxels of each model in this task into its dense grid, and hashes the grid.
+    static void _vox_decode_models_task(void* _task_data, uint32_t task_index) {
+        const _vox_decode_models_task_data* task_data = (const _vox_decode_models_task_data*)_task_data;
+        for (uint32_t chunk_index = task_data->task_first_chunk[task_index]; chunk_index < task_data->task_first_chunk[task_index + 1]; chunk_index++) {
+            const _vox_xyzi_chunk* chunk = &task_data->chunks[chunk_index];
+            ogt_vox_model* model = chunk->model;
+            // models without a grid are sparse models.
+            if (!model->voxel_data) {
+                _vox_build_sparse_model(chunk, task_data->color_remap);
+                continue;
+            }
+            const uint32_t size_x = model->size_x;
+            const uint32_t size_y = model->size_y;
+            const uint32_t size_z = model->size_z;
+            uint8_t* voxel_data = (uint8_t*)model->voxel_data;
+            memset(voxel_data, 0, size_x * size_y * size_z);
+
+            // setup some strides for computing voxel index based on x/y/z
+            const uint32_t k_stride_x = 1;
+            const uint32_t k_stride_y = size_x;
+            const uint32_t k_stride_z = size_x * size_y;
+
+            // scatter the packed voxels into the grid.
+            const uint8_t* packed_voxel_data = chunk->packed_voxels;
+            for (uint32_t i = 0; i < chunk->num_voxels; i++) {
+                uint8_t x = packed_voxel_data[i * 4 + 0];
+                uint8_t y = packed_voxel_data[i * 4 + 1];
+                uint8_t z = packed_voxel_data[i * 4 + 2];
+                uint8_t color_index = packed_voxel_data[i * 4 + 3];
+                assert(x < size_x && y < size_y && z < size_z);
+                voxel_data[(x * k_stride_x) + (y * k_stride_y) + (z * k_stride_z)] = color_index;
+            }
+            // compute the hash of the voxels in this model-- used to accelerate duplicate models checking.
+            model->voxel_hash = _vox_hash(voxel_data, size_x * size_y * size_z);
+            // remap to display order palette indices. See the IMAP comment in ogt_vox_read_scene_with_flags.
+            if (task_data->color_remap)
+                _vox_remap_colors(task_data->color_remap, voxel_data, voxel_data, size_x * size_y * size_z);
+        }
+    }
+
+    // decodes all recorded XYZI chunks into their models. Models are independent, so this is spread across the job system.
+    static void _vox_decode_models(const _vox_array<_vox_xyzi_chunk>& xyzi_chunks, const uint8_t* color_remap, _vox_array<uint32_t>& task_first_chunk) {
+        if (!xyzi_chunks.size())
+            return;
+        // batch consecutive models into tasks that each cover a reasonable amount of voxels.
+        task_first_chunk.resize(0);
+        task_first_chunk.reserve(16);
+        task_first_chunk.push_back(0);
+        uint32_t task_voxel_count = 0;
+        for (uint32_t i = 0; i < xyzi_chunks.size(); i++) {
+            const ogt_vox_model* model = xyzi_chunks[i].model;
+            task_voxel_count += model->size_x * model->size_y * model->size_z;
+            if (task_voxel_count >= k_vox_min_voxels_per_decode_task || i + 1 == xyzi_chunks.size()) {
+                task_first_chunk.push_back(i + 1);
+                task_voxel_count = 0;
+            }
+        }
+        _vox_decode_models_task_data task_data;
+        task_data.chunks           = xyzi_chunks.data;
+        task_data.task_first_chunk = task_first_chunk.data;
+        task_data.color_remap      = color_remap;
+        _vox_run_tasks(_vox_decode_models_task, &task_data, (uint32_t)task_first_chunk.size() - 1);
+    }
+
+    // a model found while parsing chunks. Its memory is allocated once we know how much memory the whole scene needs.
+    struct _vox_pending_model {
+        uint32_t       size_x;
+        uint32_t       size_y;
+        uint32_t       size_z;
+        const uint8_t* packed_voxels;    // packed (x,y,z,color_index) voxels within the source buffer
+        uint32_t       num_voxels;       // number of packed voxels
+    };
+
+    // non-NULL placeholder in model_ptrs for models that are pending allocation, so that instances referring to them are generated.
+    static const ogt_vox_model k_vox_pending_model = { 0, 0, 0, 0, NULL };
+
+    // returns the number of bytes needed for a model allocation, rounded up so that models can be packed together in an arena.
+    static size_t _vox_model_alloc_size(const _vox_pending_model& pending_model, uint32_t read_flags) {
+        size_t model_size = sizeof(ogt_vox_model);
+        // lazy models store where their voxels are instead of a grid, sparse models store a sorted copy of 
+        // their voxels, and eager models have a grid of 1 byte for each voxel.
+        if (read_flags & k_read_scene_flags_lazy_models)
+            model_size += sizeof(_vox_xyzi_chunk);
+        else if (read_flags & k_read_scene_flags_sparse_models)
+            model_size += _vox_sparse_model_extra_size(pending_model.size_y, pending_model.size_z, pending_model.num_voxels);
+        else
+            model_size += pending_model.size_x * pending_model.size_y * pending_model.size_z;
+        return (model_size + 7) & ~(size_t)7;
+    }
+
+    // scratch state used while reading a scene. Kept between reads when the caller uses an ogt_vox_read_context.
+    struct ogt_vox_read_context {
+        _vox_array<ogt_vox_model*>     model_ptrs;
+        _vox_array<_vox_pending_model> pending_models;
+        _vox_array<_vox_xyzi_chunk>    xyzi_chunks;
+        _vox_array<_vox_scene_node_>   nodes;
+        _vox_array<ogt_vox_instance>   instances;
+        _vox_array<char>               string_data;
+        _vox_array<ogt_vox_layer>      layers;
+        _vox_array<ogt_vox_group>      groups;
+        _vox_array<uint32_t>           child_ids;
+        _vox_array<_vox_group_frame>   group_stack;
+        _vox_array<uint32_t>           scratch;     // temporary memory for the node map and the various passes over models
+    };
+
+    ogt_vox_read_context* ogt_vox_create_read_context() {
+        // a zeroed _vox_array is an empty array, so zeroed memory is a valid context.
+        return (ogt_vox_read_context*)_vox_calloc(sizeof(ogt_vox_read_context));
+    }
+
+    void ogt_vox_destroy_read_context(ogt_vox_read_context* context) {
+        if (!context)
+            return;
+        context->~ogt_vox_read_context();
+        _vox_free(context);
     }
 
     const ogt_vox_scene* ogt_vox_read_scene_with_flags(const uint8_t * buffer, uint32_t buffer_size, uint32_t read_flags) {
+        ogt_vox_read_context context;
+        return ogt_vox_read_scene_with_context(&context, buffer, buffer_size, read_flags);
+    }
+
+    const ogt_vox_scene* ogt_vox_read_scene_with_context(ogt_vox_read_context* context, const uint8_t * buffer, uint32_t buffer_size, uint32_t read_flags) {
+        // sparse models are built while reading, so they are never lazy.
+        if (read_flags & k_read_scene_flags_sparse_models)
+            read_flags &= ~k_read_scene_flags_lazy_models;
         _vox_file file = { buffer, buffer_size, 0 };
         _vox_file* fp = &file;
 
-        // parsing state/context
-        _vox_array<ogt_vox_model*>   model_ptrs;
-        _vox_array<_vox_scene_node_> nodes;
-        _vox_array<ogt_vox_instance> instances;
-        _vox_array<char>             string_data;
-        _vox_array<ogt_vox_layer>    layers;
-        _vox_array<ogt_vox_group>    groups;
-        _vox_array<uint32_t>         child_ids;
+        // parsing state/context. These arrays keep their memory in the context between reads.
+        _vox_array<ogt_vox_model*>&     model_ptrs     = context->model_ptrs;
+        _vox_array<_vox_pending_model>& pending_models = context->pending_models;
+        _vox_array<_vox_xyzi_chunk>&    xyzi_chunks    = context->xyzi_chunks;
+        _vox_array<_vox_scene_node_>&   nodes          = context->nodes;
+        _vox_array<ogt_vox_instance>&   instances      = context->instances;
+        _vox_array<char>&               string_data    = context->string_data;
+        _vox_array<ogt_vox_layer>&      layers         = context->layers;
+        _vox_array<ogt_vox_group>&      groups         = context->groups;
+        _vox_array<uint32_t>&           child_ids      = context->child_ids;
+        _vox_array<uint32_t>&           scratch        = context->scratch;
+        model_ptrs.resize(0);
+        pending_models.resize(0);
+        xyzi_chunks.resize(0);
+        nodes.resize(0);
+        instances.resize(0);
+        string_data.resize(0);
+        layers.resize(0);
+        groups.resize(0);
+        child_ids.resize(0);
+        bool                         lazy_models = (read_flags & k_read_scene_flags_lazy_models) ? true : false;
+        bool                         single_allocation = (read_flags & k_read_scene_flags_single_allocation) ? true : false;
         ogt_vox_palette              palette;
         ogt_vox_matl_array           materials;
         _vox_dictionary              dict;
@@ -859,6 +1947,8 @@
 
         // size some of our arrays to prevent resizing during the parsing for smallish cases.
         model_ptrs.reserve(64);
+        pending_models.reserve(64);
+        xyzi_chunks.reserve(64);
         instances.reserve(256);
         child_ids.reserve(256);
         nodes.reserve(16);
@@ -920,39 +2010,18 @@
                     uint32_t num_voxels_in_chunk = 0;
                     _vox_file_read(fp, &num_voxels_in_chunk, sizeof(uint32_t));
                     if (num_voxels_in_chunk != 0) {
-                        uint32_t voxel_count = size_x * size_y * size_z;
-                        ogt_vox_model * model = (ogt_vox_model*)_vox_calloc(sizeof(ogt_vox_model) + voxel_count);        // 1 byte for each voxel
-                        if (!model)
-                            return NULL;
-                        uint8_t * voxel_data = (uint8_t*)&model[1];
-
-                        // insert the model into the model array
-                        model_ptrs.push_back(model);
-
-                        // now setup the model
-                        model->size_x = size_x;
-                        model->size_y = size_y;
-                        model->size_z = size_z;
-                        model->voxel_data = voxel_data;
-
-                        // setup some strides for computing voxel index based on x/y/z
-                        const uint32_t k_stride_x = 1;
-                        const uint32_t k_stride_y = size_x;
-                        const uint32_t k_stride_z = size_x * size_y;
-
-                        // read this many voxels and store it in voxel data.
-                        const uint8_t * packed_voxel_data = (const uint8_t*)_vox_file_data_pointer(fp);
-                        for (uint32_t i = 0; i < num_voxels_in_chunk; i++) {
-                            uint8_t x = packed_voxel_data[i * 4 + 0];
-                            uint8_t y = packed_voxel_data[i * 4 + 1];
-                            uint8_t z = packed_voxel_data[i * 4 + 2];
-                            uint8_t color_index = packed_voxel_data[i * 4 + 3];
-                            assert(x < size_x && y < size_y && z < size_z);
-                            voxel_data[(x * k_stride_x) + (y * k_stride_y) + (z * k_stride_z)] = color_index;
-                        }
+                        // insert a placeholder into the model array. The model is allocated once all chunks are parsed.
+                        model_ptrs.push_back(const_cast<ogt_vox_model*>(&k_vox_pending_model));
+
+                        // record where this model's voxels are, and don't read more voxels than there are bytes left in the buffer.
+                        _vox_pending_model pending_model;
+                        pending_model.size_x        = size_x;
+                        pending_model.size_y        = size_y;
+                        pending_model.size_z        = size_z;
+                        pending_model.packed_voxels = (const uint8_t*)_vox_file_data_pointer(fp);
+                        pending_model.num_voxels    = _vox_min(num_voxels_in_chunk, (buffer_size - _vox_min(fp->offset, buffer_size)) / 4);
+                        pending_models.push_back(pending_model);
                         _vox_file_seek_forwards(fp, num_voxels_in_chunk * 4);
-                        // compute the hash of the voxels in this model-- used to accelerate duplicate models checking.
-                        model->voxel_hash = _vox_hash(voxel_data, size_x * size_y * size_z);
                     }
                     else {
                         model_ptrs.push_back(NULL);
@@ -973,19 +2042,9 @@
                     // Parse the node dictionary, which can contain:
                     //   _name:   string
                     //   _hidden: 0/1
-                    char node_name[64];
-                    bool hidden = false;
-                    node_name[0] = 0;
-                    {
-                        _vox_file_read_dict(&dict, fp);
-                        const char* name_string = _vox_dict_get_value_as_string(&dict, "_name");
-                        if (name_string)
-                            _vox_strcpy_static(node_name, name_string);
-                        // if we got a hidden attribute - assign it now.
-                        const char* hidden_string = _vox_dict_get_value_as_string(&dict, "_hidden", "0");
-                        if (hidden_string)
-                            hidden = (hidden_string[0] == '1' ? true : false);
-                    }
+                    _vox_file_read_dict(&dict, fp);
+                    _vox_str_view node_name = _vox_dict_get_value(&dict, k_vox_dict_key_name);
+                    bool hidden = _vox_dict_get_value_as_bool(&dict, k_vox_dict_key_hidden);
 
 
                     // get other properties.
@@ -1003,22 +2062,20 @@
                     ogt_vox_transform frame_transform;
                     {
                         _vox_file_read_dict(&dict, fp);
-                        const char* rotation_value    = _vox_dict_get_value_as_string(&dict, "_r");
-                        const char* translation_value = _vox_dict_get_value_as_string(&dict, "_t");
-                        frame_transform = _vox_make_transform_from_dict_strings(rotation_value, translation_value);
+                        frame_transform = _vox_make_transform_from_dict(&dict);
                     }
                     // setup the transform node.
                     {
-                        nodes.grow_to_fit_index(node_id);
-                        _vox_scene_node_* transform_node = &nodes[node_id];
-                        assert(transform_node);
+                        nodes.push_back(_vox_scene_node_());
+                        _vox_scene_node_* transform_node = &nodes[nodes.size() - 1];
                         transform_node->node_type = k_nodetype_transform;
+                        transform_node->node_id   = node_id;
                         transform_node->u.transform.child_node_id = child_node_id;
                         transform_node->u.transform.layer_id      = layer_id;
                         transform_node->u.transform.transform     = frame_transform;
                         transform_node->u.transform.hidden        = hidden;
-                        // assign the name
-                        _vox_strcpy_static(transform_node->u.transform.name, node_name);
+                        transform_node->u.transform.name          = node_name;
+                        transform_node->u.transform.name_offset   = 0;
                     }
                     break;
                 }
@@ -1031,11 +2088,13 @@
                     _vox_file_read_dict(&dict, fp);
 
                     // setup the group node 
-                    nodes.grow_to_fit_index(node_id);
-                    _vox_scene_node_* group_node = &nodes[node_id];
+                    nodes.push_back(_vox_scene_node_());
+                    _vox_scene_node_* group_node = &nodes[nodes.size() - 1];
                     group_node->node_type = k_nodetype_group;
+                    group_node->node_id   = node_id;
                     group_node->u.group.first_child_node_id_index = 0;
                     group_node->u.group.num_child_nodes           = 0;
+                    group_node->u.group.on_stack                  = false;
 
                     // setup all child scene nodes to point back to this node.
                     uint32_t num_child_nodes = 0;
@@ -1058,9 +2117,10 @@
                     _vox_file_read(fp, &node_id, sizeof(node_id));
 
                     // setup the shape node 
-                    nodes.grow_to_fit_index(node_id);
-                    _vox_scene_node_* shape_node = &nodes[node_id];
+                    nodes.push_back(_vox_scene_node_());
+                    _vox_scene_node_* shape_node = &nodes[nodes.size() - 1];
                     shape_node->node_type = k_nodetype_shape;
+                    shape_node->node_id   = node_id;
                     shape_node->u.shape.model_id = UINT32_MAX;
 
                     // parse the node dictionary - data is unused.
@@ -1100,16 +2160,14 @@
 
                     // if we got a layer name from the LAYR dictionary, allocate space in string_data for it and keep track of the index 
                     // within string data. This will be patched to a real pointer at the very end.
-                    const char* name_string = _vox_dict_get_value_as_string(&dict, "_name", NULL);
-                    if (name_string) {
+                    _vox_str_view name_string = _vox_dict_get_value(&dict, k_vox_dict_key_name);
+                    if (name_string.data) {
                         layers[layer_id].name = (const char*)(string_data.size());
-                        size_t name_size = _vox_strlen(name_string) + 1;       // +1 for terminator
-                        string_data.push_back_many(name_string, name_size);
+                        string_data.push_back_many(name_string.data, name_string.size);
+                        string_data.push_back(0);    // terminator
                     }
                     // if we got a hidden attribute - assign it now.
-                    const char* hidden_string = _vox_dict_get_value_as_string(&dict, "_hidden", "0");
-                    if (hidden_string)
-                        layers[layer_id].hidden = (hidden_string[0] == '1' ? true : false);
+                    layers[layer_id].hidden = _vox_dict_get_value_as_bool(&dict, k_vox_dict_key_hidden);
                     break;
                 }
                 // we don't handle MATL/MATT/rOBJ or any other chunks for now, so we just skip the chunk payload.
@@ -1119,97 +2177,7 @@
                     _vox_file_read(fp, &material_id, sizeof(material_id));
                     material_id = material_id & 0xFF; // incoming material 256 is material 0
                     _vox_file_read_dict(&dict, fp);
-                    const char* type_string = _vox_dict_get_value_as_string(&dict, "_type", NULL);
-                    if (type_string) {
-                        if (0 == _vox_strcmp(type_string,"_diffuse")) {
-                            materials.matl[material_id].type = ogt_matl_type_diffuse;
-                        }
-                        else if (0 == _vox_strcmp(type_string,"_metal")) {
-                            materials.matl[material_id].type = ogt_matl_type_metal;
-                        }
-                        else if (0 == _vox_strcmp(type_string,"_glass")) {
-                            materials.matl[material_id].type = ogt_matl_type_glass;
-                        }
-                        else if (0 == _vox_strcmp(type_string,"_emit")) {
-                            materials.matl[material_id].type = ogt_matl_type_emit;
-                        }
-                        else if (0 == _vox_strcmp(type_string,"_blend")) {
-                            materials.matl[material_id].type = ogt_matl_type_blend;
-                        }
-                        else if (0 == _vox_strcmp(type_string,"_media")) {
-                            materials.matl[material_id].type = ogt_matl_type_media;
-                        }
-                    }
-                    const char* metal_string = _vox_dict_get_value_as_string(&dict, "_metal", NULL);
-                    if (metal_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_metal;
-                        materials.matl[material_id].metal = (float)atof(metal_string);
-                    }
-                    const char* rough_string = _vox_dict_get_value_as_string(&dict, "_rough", NULL);
-                    if (rough_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_rough;
-                        materials.matl[material_id].rough = (float)atof(rough_string);
-                    }
-                    const char* spec_string = _vox_dict_get_value_as_string(&dict, "_spec", NULL);
-                    if (spec_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_spec;
-                        materials.matl[material_id].spec = (float)atof(spec_string);
-                    }
-                    const char* ior_string = _vox_dict_get_value_as_string(&dict, "_ior", NULL);
-                    if (ior_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_ior;
-                        materials.matl[material_id].ior = (float)atof(ior_string);
-                    }
-                    const char* att_string = _vox_dict_get_value_as_string(&dict, "_att", NULL);
-                    if (att_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_att;
-                        materials.matl[material_id].att = (float)atof(att_string);
-                    }
-                    const char* flux_string = _vox_dict_get_value_as_string(&dict, "_flux", NULL);
-                    if (flux_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_flux;
-                        materials.matl[material_id].flux = (float)atof(flux_string);
-                    }
-                    const char* emit_string = _vox_dict_get_value_as_string(&dict, "_emit", NULL);
-                    if (emit_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_emit;
-                        materials.matl[material_id].emit = (float)atof(emit_string);
-                    }
-                    const char* ldr_string = _vox_dict_get_value_as_string(&dict, "_ldr", NULL);
-                    if (ldr_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_ldr;
-                        materials.matl[material_id].ldr = (float)atof(ldr_string);
-                    }
-                    const char* trans_string = _vox_dict_get_value_as_string(&dict, "_trans", NULL);
-                    if (trans_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_trans;
-                        materials.matl[material_id].trans = (float)atof(trans_string);
-                    }
-                    const char* alpha_string = _vox_dict_get_value_as_string(&dict, "_alpha", NULL);
-                    if (alpha_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_alpha;
-                        materials.matl[material_id].alpha = (float)atof(alpha_string);
-                    }
-                    const char* d_string = _vox_dict_get_value_as_string(&dict, "_d", NULL);
-                    if (d_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_d;
-                        materials.matl[material_id].d = (float)atof(d_string);
-                    }
-                    const char* sp_string = _vox_dict_get_value_as_string(&dict, "_sp", NULL);
-                    if (sp_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_sp;
-                        materials.matl[material_id].sp = (float)atof(sp_string);
-                    }
-                    const char* g_string = _vox_dict_get_value_as_string(&dict, "_g", NULL);
-                    if (g_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_g;
-                        materials.matl[material_id].g = (float)atof(g_string);
-                    }
-                    const char* media_string = _vox_dict_get_value_as_string(&dict, "_media", NULL);
-                    if (media_string) {
-                        materials.matl[material_id].content_flags |= k_ogt_vox_matl_have_media;
-                        materials.matl[material_id].media = (float)atof(media_string);
-                    }
+                    _vox_read_matl_from_dict(&dict, &materials.matl[material_id]);
                     break;
                 }
                 case CHUNK_ID_MATT:
@@ -1236,7 +2204,7 @@
                 root_group.hidden             = false;
                 groups.push_back(root_group);
             }
-            generate_instances_for_node(nodes, 0, child_ids, 0, _vox_transform_identity(), model_ptrs, NULL, false, instances, string_data, groups, k_invalid_group_index, generate_groups);
+            _vox_generate_instances(nodes, child_ids, model_ptrs, generate_groups, scratch, context->group_stack, instances, string_data, groups);
         }
         else if (model_ptrs.size() == 1) {
             // add a single instance
@@ -1273,6 +2241,7 @@
         // To ensure our indices are in the same order as displayed by magicavoxel within the palette
         // window, we apply the mapping from the IMAP chunk both to the color palette and indices within each 
         // voxel model.
+        uint8_t color_remap[256];
         if (found_index_map_chunk)
         {
             // the imap chunk maps from display index to actual index.
@@ -1298,18 +2267,75 @@
             }
 
 
-            // ensure that all models are remapped so they are using display order palette indices.
-            for (uint32_t i = 0; i < model_ptrs.size(); i++) {
-                ogt_vox_model* model = model_ptrs[i];
-                if (model) {
-                    uint32_t num_voxels = model->size_x * model->size_y * model->size_z;
-                    uint8_t* voxels = (uint8_t*)&model[1];
-                    for (uint32_t j = 0; j < num_voxels; j++)
-                        voxels[j] = 1 + index_map_inverse[voxels[j]];
+            // ensure that all models are remapped so they are using display order palette indices. This
+            // is done by _vox_decode_models or ogt_vox_get_model_voxels as each model is decoded.
+            for (uint32_t i = 0; i < 256; i++)
+                color_remap[i] = (uint8_t)(1 + index_map_inverse[i]);
+        }
+
+        // now that we know everything the scene contains, we can allocate it. If we're placing it all in one arena, the 
+        // scene header, name strings, arrays and models are laid out in that order, each starting on an 8 byte boundary.
+        const size_t scene_header_size = (sizeof(ogt_vox_scene) + sizeof(_vox_scene_internal) + string_data.size() + 7) & ~(size_t)7;
+        uint8_t* arena = NULL;
+        uint8_t* arena_cursor = NULL;
+        if (single_allocation) {
+            size_t arrays_size = 0;
+            arrays_size += (sizeof(ogt_vox_model*)   * model_ptrs.size() + 7) & ~(size_t)7;
+            arrays_size += (sizeof(ogt_vox_instance) * instances.size()  + 7) & ~(size_t)7;
+            arrays_size += (sizeof(ogt_vox_layer)    * layers.size()     + 7) & ~(size_t)7;
+            arrays_size += (sizeof(ogt_vox_group)    * groups.size()     + 7) & ~(size_t)7;
+            size_t models_size = 0;
+            for (uint32_t i = 0; i < pending_models.size(); i++)
+                models_size += _vox_model_alloc_size(pending_models[i], read_flags);
+            arena = (uint8_t*)_vox_malloc(scene_header_size + arrays_size + models_size);
+            if (!arena)
+                return NULL;
+            arena_cursor = arena + scene_header_size + arrays_size;
+        }
+
+        // allocate all models, either individually or from the arena, and setup everything we know about them.
+        // The grid (or sparse voxels) and hash are filled in by _vox_decode_models below, or by ogt_vox_get_model_voxels 
+        // for lazy models.
+        for (uint32_t i = 0, pending_index = 0; i < model_ptrs.size(); i++) {
+            if (!model_ptrs[i])
+                continue;
+            const _vox_pending_model& pending_model = pending_models[pending_index++];
+            size_t model_size = _vox_model_alloc_size(pending_model, read_flags);
+            ogt_vox_model* model = (ogt_vox_model*)(arena_cursor ? arena_cursor : _vox_malloc(model_size));
+            if (!model) {
+                // release the models allocated so far. The rest of model_ptrs are still placeholders or NULL.
+                for (uint32_t j = 0; j < i; j++) {
+                    if (model_ptrs[j] && model_ptrs[j] != &k_vox_pending_model)
+                        _vox_free(model_ptrs[j]);
                 }
+                _vox_free(arena);
+                return NULL;
             }
+            if (arena_cursor)
+                arena_cursor += model_size;
+            model_ptrs[i] = model;
+            model->size_x     = pending_model.size_x;
+            model->size_y     = pending_model.size_y;
+            model->size_z     = pending_model.size_z;
+            model->voxel_hash = 0;
+            model->voxel_data = (read_flags & (k_read_scene_flags_lazy_models | k_read_scene_flags_sparse_models)) ? NULL : (const uint8_t*)&model[1];
+
+            _vox_xyzi_chunk xyzi_chunk;
+            xyzi_chunk.model         = model;
+            xyzi_chunk.packed_voxels = pending_model.packed_voxels;
+            xyzi_chunk.num_voxels    = pending_model.num_voxels;
+            xyzi_chunk.tag           = lazy_models ? k_vox_xyzi_chunk_tag_lazy : 0;
+            xyzi_chunk.color_remap   = NULL;
+            xyzi_chunk.sparse_grid   = NULL;
+            if (lazy_models)
+                *(_vox_xyzi_chunk*)&model[1] = xyzi_chunk;
+            else
+                xyzi_chunks.push_back(xyzi_chunk);
         }
 
+        // now that we know where all models are in the buffer, decode their voxel grids.
+        _vox_decode_models(xyzi_chunks, found_index_map_chunk ? color_remap : NULL, scratch);
+
         // rotate the scene palette now so voxel indices can just map straight into the palette
         {
             ogt_vox_rgba last_color = palette.color[255];
@@ -1319,24 +2345,10 @@
             palette.color[0].a = 0;  // alpha is zero for the 0th color as that color index represents a transparent voxel.
         }
 
-        // check for models that are identical by doing a pair-wise compare. If we find identical
-        // models, we'll end up with NULL gaps in the model_ptrs array, but instances will have 
-        // been remapped to keep the earlier model.
-        for (uint32_t i = 0; i < model_ptrs.size(); i++) {
-            if (!model_ptrs[i])
-                continue;
-            for (uint32_t j = i+1; j < model_ptrs.size(); j++) {
-                if (!model_ptrs[j] || !_vox_models_are_equal(model_ptrs[i], model_ptrs[j]))
-                    continue;
-                // model i and model j are the same, so free model j and keep model i.
-                _vox_free(model_ptrs[j]);
-                model_ptrs[j] = NULL;
-                // remap all instances that were referring to j to now refer to i.
-                for (uint32_t k = 0; k < instances.size(); k++)
-                    if (instances[k].model_index == j)
-                        instances[k].model_index = i;
-            }
-        }
+        // check for models that are identical. If we find identical models, we'll end up with NULL gaps 
+        // in the model_ptrs array, but instances will have been remapped to keep the earlier model.
+        if (!(read_flags & k_read_scene_flags_keep_duplicate_models))
+            _vox_remove_duplicate_models(model_ptrs, instances, !single_allocation, scratch);
 
         // sometimes a model can be created which has no solid voxels within just due to the
         // authoring flow within magicavoxel. We have already have prevented creation of 
@@ -1352,7 +2364,8 @@
             }
             if (found_empty_model) {
                 // build a remap table for all instances and simultaneously compact the model_ptrs array.
-                uint32_t* model_remap = (uint32_t*)_vox_malloc(model_ptrs.size() * sizeof(uint32_t));
+                scratch.resize(model_ptrs.size());
+                uint32_t* model_remap = &scratch[0];
                 uint32_t num_output_models = 0;
                 for (uint32_t i = 0; i < model_ptrs.size(); i++) {
                     if (model_ptrs[i] != NULL) {
@@ -1372,24 +2385,38 @@
                     assert(new_model_index != UINT32_MAX);   // we should have suppressed instances already that point to NULL models.
                     instances[i].model_index = new_model_index;
                 }
-
-                // free remap table
-                _vox_free(model_remap);
-                model_remap = NULL;
             }
         }
 
         // finally, construct the output scene..
-        size_t scene_size = sizeof(ogt_vox_scene) + string_data.size();
-        ogt_vox_scene* scene = (ogt_vox_scene*)_vox_calloc(scene_size);
+        ogt_vox_scene* scene = NULL;
+        if (arena) {
+            // the scene header is at the start of the arena, followed by the arrays.
+            scene = (ogt_vox_scene*)arena;
+            memset(scene, 0, sizeof(ogt_vox_scene) + sizeof(_vox_scene_internal));
+            arena_cursor = arena + scene_header_size;
+        }
+        else {
+            scene = (ogt_vox_scene*)_vox_calloc(sizeof(ogt_vox_scene) + sizeof(_vox_scene_internal) + string_data.size());
+        }
         {
+            // setup the library-private part of the scene. lazy models need the color remap when they are decoded, so
+            // it is kept with the scene and referenced from each model's chunk.
+            _vox_scene_internal* scene_internal = _vox_get_scene_internal(scene);
+            scene_internal->read_flags = read_flags;
+            if (lazy_models && found_index_map_chunk) {
+                memcpy(scene_internal->color_remap, color_remap, sizeof(color_remap));
+                for (uint32_t i = 0; i < model_ptrs.size(); i++)
+                    _vox_get_model_chunk(model_ptrs[i])->color_remap = scene_internal->color_remap;
+            }
+
             // copy name data into the scene
-            char* scene_string_data = (char*)&scene[1];
+            char* scene_string_data = (char*)&scene_internal[1];
             memcpy(scene_string_data, &string_data[0], sizeof(char) * string_data.size());
 
             // copy instances over to scene, and sort them so that instances with the same model are contiguous.
             size_t num_scene_instances = instances.size();
-            ogt_vox_instance* scene_instances = (ogt_vox_instance*)_vox_malloc(sizeof(ogt_vox_instance) * num_scene_instances);
+            ogt_vox_instance* scene_instances = (ogt_vox_instance*)_vox_scene_array_alloc(arena_cursor, sizeof(ogt_vox_instance) * num_scene_instances);
             if (num_scene_instances) {
                 memcpy(scene_instances, &instances[0], sizeof(ogt_vox_instance) * num_scene_instances);
                 qsort(scene_instances, num_scene_instances, sizeof(ogt_vox_instance), _vox_ordered_compare_instance);
@@ -1399,7 +2426,7 @@
 
             // copy model pointers over to the scene,
             size_t num_scene_models = model_ptrs.size();
-            ogt_vox_model** scene_models = (ogt_vox_model * *)_vox_malloc(sizeof(ogt_vox_model*) * num_scene_models);
+            ogt_vox_model** scene_models = (ogt_vox_model * *)_vox_scene_array_alloc(arena_cursor, sizeof(ogt_vox_model*) * num_scene_models);
             if (num_scene_models)
                 memcpy(scene_models, &model_ptrs[0], sizeof(ogt_vox_model*) * num_scene_models);
             scene->models     = (const ogt_vox_model **)scene_models;
@@ -1407,14 +2434,14 @@
 
             // copy layer pointers over to the scene
             size_t num_scene_layers = layers.size();
-            ogt_vox_layer* scene_layers = (ogt_vox_layer*)_vox_malloc(sizeof(ogt_vox_layer) * num_scene_layers);
+            ogt_vox_layer* scene_layers = (ogt_vox_layer*)_vox_scene_array_alloc(arena_cursor, sizeof(ogt_vox_layer) * num_scene_layers);
             memcpy(scene_layers, &layers[0], sizeof(ogt_vox_layer) * num_scene_layers);
             scene->layers     = scene_layers;
             scene->num_layers = (uint32_t)num_scene_layers;
 
             // copy group pointers over to the scene
             size_t num_scene_groups = groups.size();
-            ogt_vox_group* scene_groups = num_scene_groups ? (ogt_vox_group*)_vox_malloc(sizeof(ogt_vox_group) * num_scene_groups) : NULL;
+            ogt_vox_group* scene_groups = num_scene_groups ? (ogt_vox_group*)_vox_scene_array_alloc(arena_cursor, sizeof(ogt_vox_group) * num_scene_groups) : NULL;
             if (num_scene_groups)
                 memcpy(scene_groups, &groups[0], sizeof(ogt_vox_group)* num_scene_groups);
             scene->groups     = scene_groups;
@@ -1443,31 +2470,395 @@
         return ogt_vox_read_scene_with_flags(buffer, buffer_size, 0);
     }
 
+    // tries to memory-map the file, returns false if the platform doesn't support it or mapping failed.
+    static bool _vox_mapped_file_try_map(_vox_mapped_file* file, const char* filename) {
+    #if defined(_VOX_HAVE_MMAP) && defined(_WIN32)
+        HANDLE file_handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file_handle == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0 || file_size.QuadPart > UINT32_MAX) {
+            CloseHandle(file_handle);
+            return false;
+        }
+        HANDLE mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        // the view keeps its own reference to the file, so we can close our handles right away.
+        const void* view = mapping_handle ? MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (mapping_handle)
+            CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        if (!view)
+            return false;
+        file->data      = (const uint8_t*)view;
+        file->size      = (uint32_t)file_size.QuadPart;
+        file->is_mapped = true;
+        return true;
+    #elif defined(_VOX_HAVE_MMAP)
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0 || (uint64_t)file_stat.st_size > UINT32_MAX) {
+            close(fd);
+            return false;
+        }
+        // the mapping keeps its own reference to the file, so we can close the descriptor right away.
+        void* view = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED)
+            return false;
+        #ifdef MADV_SEQUENTIAL
+            madvise(view, (size_t)file_stat.st_size, MADV_SEQUENTIAL);  // chunks are parsed front-to-back
+        #endif
+        file->data      = (const uint8_t*)view;
+        file->size      = (uint32_t)file_stat.st_size;
+        file->is_mapped = true;
+        return true;
+    #else
+        (void)file; (void)filename;
+        return false;
+    #endif
+    }
+
+    // loads the file into a heap buffer. This is the fallback for when the file can't be memory-mapped.
+    static bool _vox_mapped_file_try_load(_vox_mapped_file* file, const char* filename) {
+    #if defined(_MSC_VER) && _MSC_VER >= 1400
+        FILE* fp;
+        if (0 != fopen_s(&fp, filename, "rb"))
+            fp = 0;
+    #else
+        FILE* fp = fopen(filename, "rb");
+    #endif
+        if (!fp)
+            return false;
+        fseek(fp, 0, SEEK_END);
+        long file_size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        if (file_size <= 0 || (unsigned long)file_size > UINT32_MAX) {
+            fclose(fp);
+            return false;
+        }
+        uint8_t* data = (uint8_t*)_vox_malloc((size_t)file_size);
+        bool read_ok = data && fread(data, (size_t)file_size, 1, fp) == 1;
+        fclose(fp);
+        if (!read_ok) {
+            _vox_free(data);
+            return false;
+        }
+        file->data      = data;
+        file->size      = (uint32_t)file_size;
+        file->is_mapped = false;
+        return true;
+    }
+
+    static bool _vox_mapped_file_open(_vox_mapped_file* file, const char* filename) {
+        file->data      = NULL;
+        file->size      = 0;
+        file->is_mapped = false;
+        return _vox_mapped_file_try_map(file, filename) || _vox_mapped_file_try_load(file, filename);
+    }
+
+    static void _vox_mapped_file_close(_vox_mapped_file* file) {
+        if (!file->data)
+            return;
+        if (file->is_mapped) {
+    #if defined(_VOX_HAVE_MMAP) && defined(_WIN32)
+            UnmapViewOfFile(file->data);
+    #elif defined(_VOX_HAVE_MMAP)
+            munmap((void*)file->data, file->size);
+    #endif
+        }
+        else {
+            _vox_free((void*)file->data);
+        }
+        file->data = NULL;
+        file->size = 0;
+    }
+
+    const ogt_vox_scene* ogt_vox_read_scene_from_file(const char* filename, uint32_t read_flags) {
+        _vox_mapped_file file;
+        if (!_vox_mapped_file_open(&file, filename))
+            return NULL;
+        // the scene only references the file contents if models are decoded lazily, in which case the scene takes
+        // ownership of the file. Otherwise we can release the file immediately.
+        const ogt_vox_scene* scene = ogt_vox_read_scene_with_flags(file.data, file.size, read_flags);
+        if (scene && (_vox_get_scene_internal(scene)->read_flags & k_read_scene_flags_lazy_models))
+            _vox_get_scene_internal(scene)->mapped_file = file;
+        else
+            _vox_mapped_file_close(&file);
+        return scene;
+    }
+
+    const uint8_t* ogt_vox_get_model_voxels(const ogt_vox_scene* scene, uint32_t model_index) {
+        assert(model_index < scene->num_models);
+        ogt_vox_model* model = const_cast<ogt_vox_model*>(scene->models[model_index]);
+        if (model->voxel_data)
+            return model->voxel_data;
+
+        // this is a lazy or sparse model. Sparse models keep their dense grid in their chunk, so that voxel_data stays NULL
+        // and the model can still be recognized as sparse. Their voxels are already remapped and hashed, so they only need
+        // scattering into the grid.
+        _vox_xyzi_chunk* chunk = _vox_get_model_chunk(model);
+        const uint32_t num_grid_voxels = model->size_x * model->size_y * model->size_z;
+        if (chunk->tag == k_vox_xyzi_chunk_tag_sparse) {
+            if (!chunk->sparse_grid) {
+                uint8_t* grid = (uint8_t*)_vox_malloc(num_grid_voxels);
+                if (!grid)
+                    return NULL;
+                memset(grid, 0, num_grid_voxels);
+                const ogt_vox_sparse_model* sparse_model = _vox_get_sparse_model(model);
+                for (uint32_t i = 0; i < sparse_model->num_voxels; i++) {
+                    const ogt_vox_packed_voxel& voxel = sparse_model->voxels[i];
+                    grid[voxel.x + (voxel.y * model->size_x) + (voxel.z * model->size_x * model->size_y)] = voxel.color_index;
+                }
+                chunk->sparse_grid = grid;
+            }
+            return chunk->sparse_grid;
+        }
+
+        // lazy models haven't been decoded yet. Allocate their grid and decode the voxels they refer to.
+        model->voxel_data = (const uint8_t*)_vox_malloc(num_grid_voxels);
+        if (!model->voxel_data)
+            return NULL;
+        const uint32_t task_first_chunk[2] = { 0, 1 };
+        _vox_decode_models_task_data task_data;
+        task_data.chunks           = chunk;
+        task_data.task_first_chunk = task_first_chunk;
+        task_data.color_remap      = chunk->color_remap;
+        _vox_decode_models_task(&task_data, 0);
+        return model->voxel_data;
+    }
+
+    const ogt_vox_sparse_model* ogt_vox_get_sparse_model(const ogt_vox_scene* scene, uint32_t model_index) {
+        assert(model_index < scene->num_models);
+        // only lazy and sparse models are without voxel_data, and they are told apart by the tag of their chunk.
+        const ogt_vox_model* model = scene->models[model_index];
+        if (model->voxel_data || _vox_get_model_chunk(model)->tag != k_vox_xyzi_chunk_tag_sparse)
+            return NULL;
+        return _vox_get_sparse_model(model);
+    }
+
+    bool ogt_vox_visit_chunks(const uint8_t* buffer, uint32_t buffer_size, const ogt_vox_chunk_visitor* visitor) {
+        _vox_file file = { buffer, buffer_size, 0 };
+        _vox_file* fp = &file;
+        _vox_dictionary dict;
+        _vox_array<uint32_t> child_ids;
+        char name[256];    // names are handed to callbacks zero-terminated, so longer names are truncated.
+        uint32_t num_models = 0;
+
+        // load and validate fileheader and file version.
+        uint32_t file_header = 0;
+        uint32_t file_version = 0;
+        _vox_file_read(fp, &file_header, sizeof(uint32_t));
+        _vox_file_read(fp, &file_version, sizeof(uint32_t));
+        if (file_header != CHUNK_ID_VOX_ || file_version != 150)
+            return false;
+
+        // parse chunks until we reach the end of the file/buffer, or a callback asks us to stop.
+        bool keep_going = true;
+        while (keep_going && !_vox_file_eof(fp))
+        {
+            // read the fields common to all chunks
+            uint32_t chunk_id         = 0;
+            uint32_t chunk_size       = 0;
+            uint32_t chunk_child_size = 0;
+            _vox_file_read(fp, &chunk_id, sizeof(uint32_t));
+            _vox_file_read(fp, &chunk_size, sizeof(uint32_t));
+            _vox_file_read(fp, &chunk_child_size, sizeof(uint32_t));
+            // remember where the next chunk starts, so each case only has to parse as much as its callback needs.
+            // MAIN has no payload of its own, so its children follow directly.
+            const uint32_t next_chunk_offset = fp->offset + _vox_min(chunk_size, buffer_size - _vox_min(fp->offset, buffer_size));
+
+            switch (chunk_id)
+            {
+                case CHUNK_ID_SIZE:
+                {
+                    if (visitor->visit_size) {
+                        uint32_t size[3] = { 0, 0, 0 };
+                        _vox_file_read(fp, size, sizeof(size));
+                        keep_going = visitor->visit_size(visitor->user_data, size[0], size[1], size[2]);
+                    }
+                    break;
+                }
+                case CHUNK_ID_XYZI:
+                {
+                    if (visitor->visit_xyzi) {
+                        uint32_t num_voxels_in_chunk = 0;
+                        _vox_file_read(fp, &num_voxels_in_chunk, sizeof(uint32_t));
+                        // don't hand out more voxels than there are bytes left in the buffer.
+                        uint32_t num_voxels = _vox_min(num_voxels_in_chunk, (buffer_size - _vox_min(fp->offset, buffer_size)) / 4);
+                        keep_going = visitor->visit_xyzi(visitor->user_data, num_models, (const uint8_t*)_vox_file_data_pointer(fp), num_voxels);
+                    }
+                    num_models++;
+                    break;
+                }
+                case CHUNK_ID_RGBA:
+                {
+                    if (visitor->visit_palette) {
+                        ogt_vox_palette file_palette;
+                        memset(&file_palette, 0, sizeof(file_palette));
+                        _vox_file_read(fp, &file_palette, sizeof(file_palette));
+                        // rotate the palette so the color indices in XYZI chunks map straight into it, just like the scene reader does.
+                        ogt_vox_palette palette;
+                        for (uint32_t i = 0; i < 256; i++)
+                            palette.color[i] = file_palette.color[(i + 255) & 0xFF];
+                        palette.color[0].a = 0;
+                        keep_going = visitor->visit_palette(visitor->user_data, &palette);
+                    }
+                    break;
+                }
+                case CHUNK_ID_IMAP:
+                {
+                    if (visitor->visit_index_map) {
+                        uint8_t index_map[256];
+                        memset(index_map, 0, sizeof(index_map));
+                        _vox_file_read(fp, index_map, sizeof(index_map));
+                        keep_going = visitor->visit_index_map(visitor->user_data, index_map);
+                    }
+                    break;
+                }
+                case CHUNK_ID_nTRN:
+                {
+                    if (visitor->visit_transform_node) {
+                        uint32_t node_id = 0;
+                        _vox_file_read(fp, &node_id, sizeof(node_id));
+
+                        // the node dictionary holds _name and _hidden.
+                        if (!_vox_file_read_dict(&dict, fp))
+                            return false;
+                        _vox_str_view name_string = _vox_dict_get_value(&dict, k_vox_dict_key_name);
+                        if (name_string.data)
+                            _vox_str_view_copy(name, sizeof(name), name_string);
+                        bool hidden = _vox_dict_get_value_as_bool(&dict, k_vox_dict_key_hidden);
+
+                        uint32_t child_node_id = 0, reserved_id = 0, layer_id = 0, num_frames = 0;
+                        _vox_file_read(fp, &child_node_id, sizeof(child_node_id));
+                        _vox_file_read(fp, &reserved_id,   sizeof(reserved_id));
+                        _vox_file_read(fp, &layer_id,      sizeof(layer_id));
+                        _vox_file_read(fp, &num_frames,    sizeof(num_frames));
+
+                        // the frame dictionary holds _r and _t.
+                        if (!_vox_file_read_dict(&dict, fp))
+                            return false;
+                        ogt_vox_transform transform = _vox_make_transform_from_dict(&dict);
+                        keep_going = visitor->visit_transform_node(visitor->user_data, node_id, child_node_id, layer_id,
+                            name_string.data ? name : NULL, hidden, &transform);
+                    }
+                    break;
+                }
+                case CHUNK_ID_nGRP:
+                {
+                    if (visitor->visit_group_node) {
+                        uint32_t node_id = 0;
+                        _vox_file_read(fp, &node_id, sizeof(node_id));
+                        // the node dictionary is unused.
+                        if (!_vox_file_read_dict(&dict, fp))
+                            return false;
+                        uint32_t num_child_nodes = 0;
+                        _vox_file_read(fp, &num_child_nodes, sizeof(num_child_nodes));
+                        // the child ids may not be aligned within the buffer, so copy them out. Never read past the chunk.
+                        num_child_nodes = _vox_min(num_child_nodes, (next_chunk_offset - _vox_min(fp->offset, next_chunk_offset)) / 4);
+                        child_ids.resize(num_child_nodes);
+                        if (num_child_nodes)
+                            _vox_file_read(fp, &child_ids[0], sizeof(uint32_t) * num_child_nodes);
+                        keep_going = visitor->visit_group_node(visitor->user_data, node_id, num_child_nodes ? &child_ids[0] : NULL, num_child_nodes);
+                    }
+                    break;
+                }
+                case CHUNK_ID_nSHP:
+                {
+                    if (visitor->visit_shape_node) {
+                        uint32_t node_id = 0;
+                        _vox_file_read(fp, &node_id, sizeof(node_id));
+                        // the node dictionary is unused.
+                        if (!_vox_file_read_dict(&dict, fp))
+                            return false;
+                        uint32_t num_shape_models = 0;
+                        uint32_t model_index = UINT32_MAX;
+                        _vox_file_read(fp, &num_shape_models, sizeof(num_shape_models));
+                        _vox_file_read(fp, &model_index, sizeof(model_index));
+                        keep_going = visitor->visit_shape_node(visitor->user_data, node_id, model_index);
+                    }
+                    break;
+                }
+                case CHUNK_ID_LAYR:
+                {
+                    if (visitor->visit_layer) {
+                        uint32_t layer_id = 0;
+                        _vox_file_read(fp, &layer_id, sizeof(layer_id));
+                        if (!_vox_file_read_dict(&dict, fp))
+                            return false;
+                        _vox_str_view name_string = _vox_dict_get_value(&dict, k_vox_dict_key_name);
+                        if (name_string.data)
+                            _vox_str_view_copy(name, sizeof(name), name_string);
+                        keep_going = visitor->visit_layer(visitor->user_data, layer_id, name_string.data ? name : NULL,
+                            _vox_dict_get_value_as_bool(&dict, k_vox_dict_key_hidden));
+                    }
+                    break;
+                }
+                case CHUNK_ID_MATL:
+                {
+                    if (visitor->visit_material) {
+                        uint32_t material_id = 0;
+                        _vox_file_read(fp, &material_id, sizeof(material_id));
+                        if (!_vox_file_read_dict(&dict, fp))
+                            return false;
+                        ogt_vox_matl material;
+                        memset(&material, 0, sizeof(material));
+                        _vox_read_matl_from_dict(&dict, &material);
+                        keep_going = visitor->visit_material(visitor->user_data, material_id & 0xFF, &material);    // incoming material 256 is material 0
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            // skip whatever part of the chunk we didn't parse. nTRN/nGRP/nSHP/LAYR/MATL contain no child chunks.
+            fp->offset = next_chunk_offset;
+        }
+        return true;
+    }
+
     void ogt_vox_destroy_scene(const ogt_vox_scene * _scene) {
         ogt_vox_scene* scene = const_cast<ogt_vox_scene*>(_scene);
-        // free models from model array
-        for (uint32_t i = 0; i < scene->num_models; i++)
-            _vox_free((void*)scene->models[i]);
-        // free model array itself
-        if (scene->models) {
-            _vox_free(scene->models);
-            scene->models = NULL;
-        }
-        // free instance array
-        if (scene->instances) {
-            _vox_free(const_cast<ogt_vox_instance*>(scene->instances));
-            scene->instances = NULL;
-        }
-        // free layer array
-        if (scene->layers) {
-            _vox_free(const_cast<ogt_vox_layer*>(scene->layers));
-            scene->layers = NULL;
-        }
-        // free groups array
-        if (scene->groups) {
-            _vox_free(const_cast<ogt_vox_group*>(scene->groups));
-            scene->groups = NULL;
+        _vox_scene_internal* scene_internal = _vox_get_scene_internal(scene);
+        // free models from model array. lazy and sparse models have their grid in a separate allocation, if they were decoded.
+        for (uint32_t i = 0; i < scene->num_models; i++) {
+            const ogt_vox_model* model = scene->models[i];
+            if (!model->voxel_data)
+                _vox_free(_vox_get_model_chunk(model)->sparse_grid);
+            else if (scene_internal->read_flags & k_read_scene_flags_lazy_models)
+                _vox_free((void*)model->voxel_data);
         }
+        // everything else is part of the scene allocation when the scene was allocated as a single arena.
+        if (!(scene_internal->read_flags & k_read_scene_flags_single_allocation)) {
+            // a model owns its grid if it directly follows the model. Merged models that share the voxel data of a source
+            // scene are allocated without one, so freeing the model never frees voxels it doesn't own.
+            for (uint32_t i = 0; i < scene->num_models; i++)
+                _vox_free((void*)scene->models[i]);
+            // free model array itself
+            if (scene->models) {
+                _vox_free(scene->models);
+                scene->models = NULL;
+            }
+            // free instance array
+            if (scene->instances) {
+                _vox_free(const_cast<ogt_vox_instance*>(scene->instances));
+                scene->instances = NULL;
+            }
+            // free layer array
+            if (scene->layers) {
+                _vox_free(const_cast<ogt_vox_layer*>(scene->layers));
+                scene->layers = NULL;
+            }
+            // free groups array
+            if (scene->groups) {
+                _vox_free(const_cast<ogt_vox_group*>(scene->groups));
+                scene->groups = NULL;
+            }
+        }
+        // release the file that lazy models were referring to, if the scene owns it.
+        _vox_mapped_file_close(&scene_internal->mapped_file);
         // finally, free the scene.
         _vox_free(scene);
     }
@@ -1504,27 +2895,82 @@
         return (row0_index) | (row1_index << 2) | (row0_negative ? 1 << 4 : 0) | (row1_negative ? 1 << 5 : 0) | (row2_negative ? 1 << 6 : 0);
     }
 
+    // size of the blocks that are handed to the write function when streaming a scene out.
+    static const uint32_t k_vox_write_block_size = 64 * 1024;
+
+    // an output stream for .vox files. Output is gathered in buffer and handed to write_func whenever buffer fills up. Without
+    // a write_func, output goes straight into buffer, which must then be big enough for all of it. Without a buffer, nothing
+    // is stored and only the offset advances, which is how the size of a file is measured before it is written.
     struct _vox_file_writeable {
-        _vox_array<uint8_t> data;
+        uint8_t*           buffer;
+        uint32_t           buffer_size;
+        uint32_t           buffer_used;
+        uint32_t           offset;             // number of bytes written so far, including any that are still in buffer
+        ogt_vox_write_func write_func;
+        void*              write_user_data;
+        bool               failed;             // set once output couldn't be written. Nothing else is stored after that.
     };
 
-    static void _vox_file_writeable_init(_vox_file_writeable* fp) {
-        fp->data.reserve(1024);
+    static void _vox_file_writeable_init(_vox_file_writeable* fp, uint8_t* buffer, uint32_t buffer_size, ogt_vox_write_func write_func, void* write_user_data) {
+        fp->buffer          = buffer;
+        fp->buffer_size     = buffer_size;
+        fp->buffer_used     = 0;
+        fp->offset          = 0;
+        fp->write_func      = write_func;
+        fp->write_user_data = write_user_data;
+        fp->failed          = false;
+    }
+    // returns true if output is only being measured, or can no longer be stored.
+    static bool _vox_file_is_counting(const _vox_file_writeable* fp) {
+        return !fp->buffer || fp->failed;
+    }
+    // hands everything that is buffered to the write function.
+    static void _vox_file_flush(_vox_file_writeable* fp) {
+        if (!fp->write_func)
+            return;
+        if (fp->buffer_used && !fp->failed)
+            fp->failed = !fp->write_func(fp->buffer, fp->buffer_used, fp->write_user_data);
+        fp->buffer_used = 0;
+    }
+    // returns space for up to max_size bytes of output, to be followed by _vox_file_commit with the number of bytes used.
+    // Returns NULL if the output is only being counted.
+    static uint8_t* _vox_file_reserve(_vox_file_writeable* fp, uint32_t max_size) {
+        if (_vox_file_is_counting(fp))
+            return NULL;
+        if (fp->buffer_used + max_size > fp->buffer_size)
+            _vox_file_flush(fp);
+        if (fp->buffer_used + max_size > fp->buffer_size) {
+            fp->failed = true;
+            return NULL;
+        }
+        return &fp->buffer[fp->buffer_used];
+    }
+    static void _vox_file_commit(_vox_file_writeable* fp, uint32_t size) {
+        if (!_vox_file_is_counting(fp))
+            fp->buffer_used += size;
+        fp->offset += size;
     }
     static void _vox_file_write(_vox_file_writeable* fp, const void* data, uint32_t data_size) {
-        fp->data.push_back_many((const uint8_t*)data, data_size);
+        fp->offset += data_size;
+        const uint8_t* src = (const uint8_t*)data;
+        while (data_size && !_vox_file_is_counting(fp)) {
+            if (fp->buffer_used == fp->buffer_size) {
+                _vox_file_flush(fp);
+                fp->failed = fp->failed || fp->buffer_used == fp->buffer_size;
+                continue;
+            }
+            uint32_t size = _vox_min(data_size, fp->buffer_size - fp->buffer_used);
+            memcpy(&fp->buffer[fp->buffer_used], src, size);
+            fp->buffer_used += size;
+            src             += size;
+            data_size       -= size;
+        }
     }
     static void _vox_file_write_uint32(_vox_file_writeable* fp, uint32_t data) {
-        fp->data.push_back_many((const uint8_t*)&data, sizeof(uint32_t));
-    }
-    static void _vox_file_write_uint8(_vox_file_writeable* fp, uint8_t data) {
-        fp->data.push_back_many((const uint8_t*)&data, sizeof(uint8_t));
+        _vox_file_write(fp, &data, sizeof(uint32_t));
     }
     static uint32_t _vox_file_get_offset(const _vox_file_writeable* fp) {
-        return (uint32_t)fp->data.count;
-    }
-    static uint8_t* _vox_file_get_data(_vox_file_writeable* fp) {
-        return &fp->data[0];
+        return fp->offset;
     }
     static void _vox_file_write_dict_key_value(_vox_file_writeable* fp, const char* key, const char* value) {
         if (key == NULL || value == NULL)
@@ -1604,37 +3050,548 @@
         _vox_file_write_dict_key_value(fp, "_t", t_string);
     }
 
-    // saves the scene out to a buffer that when saved as a .vox file can be loaded with magicavoxel.
-    uint8_t* ogt_vox_write_scene(const ogt_vox_scene* scene, uint32_t* buffer_size) {
-        _vox_file_writeable file;
-        _vox_file_writeable_init(&file);
-        _vox_file_writeable* fp = &file;
+    // solid voxel kernels. These count the solid voxels in a grid, and gather the solid voxels in part of a row of a grid as
+    // packed (x,y,z,color_index) voxels. Where SIMD is available, empty space is skipped 16 or 32 voxels at a time, and with
+    // AVX2 solid voxels are packed 8 at a time. AVX2 support is detected at runtime, everything else at compile time.
+    static uint32_t _vox_count_solid_voxels_scalar(const uint8_t* voxels, uint32_t num_voxels) {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < num_voxels; i++)
+            count += (voxels[i] != 0) ? 1 : 0;
+        return count;
+    }
+    static uint8_t* _vox_encode_solid_voxels_scalar(const uint8_t* row, uint32_t first_x, uint32_t end_x, uint32_t y, uint32_t z, uint8_t* output) {
+        for (uint32_t x = first_x; x < end_x; x++) {
+            uint8_t color_index = row[x];
+            if (color_index != 0) {
+                output[0] = (uint8_t)x;
+                output[1] = (uint8_t)y;
+                output[2] = (uint8_t)z;
+                output[3] = color_index;
+                output += 4;
+            }
+        }
+        return output;
+    }
 
-        // write file header and file version
-        _vox_file_write_uint32(fp, CHUNK_ID_VOX_);
-        _vox_file_write_uint32(fp, 150);
+    #if defined(_VOX_HAVE_SSE2) || defined(_VOX_HAVE_NEON)
+    static uint32_t _vox_lowest_bit_index(uint64_t bits) {
+        assert(bits != 0);
+    #if defined(__GNUC__) || defined(__clang__)
+        return (uint32_t)__builtin_ctzll(bits);
+    #elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, (unsigned long)bits))
+            return (uint32_t)index;
+        _BitScanForward(&index, (unsigned long)(bits >> 32));
+        return (uint32_t)index + 32;
+    #else
+        uint32_t index = 0;
+        for (; !(bits & 1); bits >>= 1)
+            index++;
+        return index;
+    #endif
+    }
+    // emits a packed voxel for every set bit in solid_bits, where bit i refers to voxel first_x + (i >> bit_shift).
+    static uint8_t* _vox_encode_solid_voxel_bits(const uint8_t* row, uint32_t first_x, uint64_t solid_bits, uint32_t bit_shift, uint32_t y, uint32_t z, uint8_t* output) {
+        for (; solid_bits; solid_bits &= solid_bits - 1) {
+            uint32_t x = first_x + (_vox_lowest_bit_index(solid_bits) >> bit_shift);
+            output[0] = (uint8_t)x;
+            output[1] = (uint8_t)y;
+            output[2] = (uint8_t)z;
+            output[3] = row[x];
+            output += 4;
+        }
+        return output;
+    }
+    #endif
 
-        // write the main chunk 
-        _vox_file_write_uint32(fp, CHUNK_ID_MAIN);
-        _vox_file_write_uint32(fp, 0);
-        _vox_file_write_uint32(fp, 0);  // this main_chunk_child_size will get patched up once everything is written.
+    #if defined(_VOX_HAVE_SSE2)
+    static uint32_t _vox_count_solid_voxels_sse2(const uint8_t* voxels, uint32_t num_voxels) {
+        const __m128i zero = _mm_setzero_si128();
+        uint32_t num_empty = 0;
+        uint32_t i = 0;
+        while (i + 16 <= num_voxels) {
+            // each byte of empty_counts can count up to 255 empty voxels before it needs summing.
+            __m128i empty_counts = zero;
+            for (uint32_t j = 0; j < 255 && i + 16 <= num_voxels; j++, i += 16)
+                empty_counts = _mm_sub_epi8(empty_counts, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&voxels[i]), zero));
+            __m128i sums = _mm_sad_epu8(empty_counts, zero);
+            num_empty += (uint32_t)_mm_cvtsi128_si32(sums) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+        }
+        return (i - num_empty) + _vox_count_solid_voxels_scalar(&voxels[i], num_voxels - i);
+    }
+    static uint8_t* _vox_encode_solid_voxels_sse2(const uint8_t* row, uint32_t first_x, uint32_t end_x, uint32_t y, uint32_t z, uint8_t* output) {
+        const __m128i zero = _mm_setzero_si128();
+        uint32_t x = first_x;
+        for (; x + 16 <= end_x; x += 16) {
+            uint32_t solid_bits = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&row[x]), zero)) & 0xFFFF;
+            output = _vox_encode_solid_voxel_bits(row, x, solid_bits, 0, y, z, output);
+        }
+        return _vox_encode_solid_voxels_scalar(row, x, end_x, y, z, output);
+    }
+    #endif
 
-        // we need to know how to patch up the main chunk size after we've written everything
-        const uint32_t offset_post_main_chunk = _vox_file_get_offset(fp);
+    #if defined(_VOX_HAVE_AVX2)
+    static uint32_t _vox_count_bits(uint32_t bits) {
+        bits = bits - ((bits >> 1) & 0x55555555);
+        bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+        return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+    }
+    // for each mask of 8 voxels, the indices of its solid voxels packed into nibbles, lowest first.
+    static const uint32_t k_vox_solid_voxel_indices[256] = {
+        0x00000000, 0x00000000, 0x00000001, 0x00000010, 0x00000002, 0x00000020, 0x00000021, 0x00000210,
+        0x00000003, 0x00000030, 0x00000031, 0x00000310, 0x00000032, 0x00000320, 0x00000321, 0x00003210,
+        0x00000004, 0x00000040, 0x00000041, 0x00000410, 0x00000042, 0x00000420, 0x00000421, 0x00004210,
+        0x00000043, 0x00000430, 0x00000431, 0x00004310, 0x00000432, 0x00004320, 0x00004321, 0x00043210,
+        0x00000005, 0x00000050, 0x00000051, 0x00000510, 0x00000052, 0x00000520, 0x00000521, 0x00005210,
+        0x00000053, 0x00000530, 0x00000531, 0x00005310, 0x00000532, 0x00005320, 0x00005321, 0x00053210,
+        0x00000054, 0x00000540, 0x00000541, 0x00005410, 0x00000542, 0x00005420, 0x00005421, 0x00054210,
+        0x00000543, 0x00005430, 0x00005431, 0x00054310, 0x00005432, 0x00054320, 0x00054321, 0x00543210,
+        0x00000006, 0x00000060, 0x00000061, 0x00000610, 0x00000062, 0x00000620, 0x00000621, 0x00006210,
+        0x00000063, 0x00000630, 0x00000631, 0x00006310, 0x00000632, 0x00006320, 0x00006321, 0x00063210,
+        0x00000064, 0x00000640, 0x00000641, 0x00006410, 0x00000642, 0x00006420, 0x00006421, 0x00064210,
+        0x00000643, 0x00006430, 0x00006431, 0x00064310, 0x00006432, 0x00064320, 0x00064321, 0x00643210,
+        0x00000065, 0x00000650, 0x00000651, 0x00006510, 0x00000652, 0x00006520, 0x00006521, 0x00065210,
+        0x00000653, 0x00006530, 0x00006531, 0x00065310, 0x00006532, 0x00065320, 0x00065321, 0x00653210,
+        0x00000654, 0x00006540, 0x00006541, 0x00065410, 0x00006542, 0x00065420, 0x00065421, 0x00654210,
+        0x00006543, 0x00065430, 0x00065431, 0x00654310, 0x00065432, 0x00654320, 0x00654321, 0x06543210,
+        0x00000007, 0x00000070, 0x00000071, 0x00000710, 0x00000072, 0x00000720, 0x00000721, 0x00007210,
+        0x00000073, 0x00000730, 0x00000731, 0x00007310, 0x00000732, 0x00007320, 0x00007321, 0x00073210,
+        0x00000074, 0x00000740, 0x00000741, 0x00007410, 0x00000742, 0x00007420, 0x00007421, 0x00074210,
+        0x00000743, 0x00007430, 0x00007431, 0x00074310, 0x00007432, 0x00074320, 0x00074321, 0x00743210,
+        0x00000075, 0x00000750, 0x00000751, 0x00007510, 0x00000752, 0x00007520, 0x00007521, 0x00075210,
+        0x00000753, 0x00007530, 0x00007531, 0x00075310, 0x00007532, 0x00075320, 0x00075321, 0x00753210,
+        0x00000754, 0x00007540, 0x00007541, 0x00075410, 0x00007542, 0x00075420, 0x00075421, 0x00754210,
+        0x00007543, 0x00075430, 0x00075431, 0x00754310, 0x00075432, 0x00754320, 0x00754321, 0x07543210,
+        0x00000076, 0x00000760, 0x00000761, 0x00007610, 0x00000762, 0x00007620, 0x00007621, 0x00076210,
+        0x00000763, 0x00007630, 0x00007631, 0x00076310, 0x00007632, 0x00076320, 0x00076321, 0x00763210,
+        0x00000764, 0x00007640, 0x00007641, 0x00076410, 0x00007642, 0x00076420, 0x00076421, 0x00764210,
+        0x00007643, 0x00076430, 0x00076431, 0x00764310, 0x00076432, 0x00764320, 0x00764321, 0x07643210,
+        0x00000765, 0x00007650, 0x00007651, 0x00076510, 0x00007652, 0x00076520, 0x00076521, 0x00765210,
+        0x00007653, 0x00076530, 0x00076531, 0x00765310, 0x00076532, 0x00765320, 0x00765321, 0x07653210,
+        0x00007654, 0x00076540, 0x00076541, 0x00765410, 0x00076542, 0x00765420, 0x00765421, 0x07654210,
+        0x00076543, 0x00765430, 0x00765431, 0x07654310, 0x00765432, 0x07654320, 0x07654321, 0x76543210,
+    };
 
-        // write out all model chunks
+    _VOX_TARGET_AVX2 static uint32_t _vox_count_solid_voxels_avx2(const uint8_t* voxels, uint32_t num_voxels) {
+        const __m256i zero = _mm256_setzero_si256();
+        uint32_t num_empty = 0;
+        uint32_t i = 0;
+        while (i + 32 <= num_voxels) {
+            // each byte of empty_counts can count up to 255 empty voxels before it needs summing.
+            __m256i empty_counts = zero;
+            for (uint32_t j = 0; j < 255 && i + 32 <= num_voxels; j++, i += 32)
+                empty_counts = _mm256_sub_epi8(empty_counts, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&voxels[i]), zero));
+            __m256i sums = _mm256_sad_epu8(empty_counts, zero);
+            __m128i sum  = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+            num_empty += (uint32_t)_mm_cvtsi128_si32(sum) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+        }
+        return (i - num_empty) + _vox_count_solid_voxels_sse2(&voxels[i], num_voxels - i);
+    }
+    _VOX_TARGET_AVX2 static uint8_t* _vox_encode_solid_voxels_avx2(const uint8_t* row, uint32_t first_x, uint32_t end_x, uint32_t y, uint32_t z, uint8_t* output) {
+        const __m256i zero         = _mm256_setzero_si256();
+        const __m256i lanes        = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i nibble_shift = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+        const __m256i nibble_mask  = _mm256_set1_epi32(0xF);
+        const __m256i packed_yz    = _mm256_set1_epi32((int)((y << 8) | (z << 16)));
+        uint32_t x = first_x;
+        for (; x + 32 <= end_x; x += 32) {
+            uint32_t solid_bits = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&row[x]), zero));
+            // a few solid voxels are quicker to emit one by one.
+            if (_vox_count_bits(solid_bits) <= 4) {
+                output = _vox_encode_solid_voxel_bits(row, x, solid_bits, 0, y, z, output);
+                continue;
+            }
+            // pack each 8 voxels that have solid ones, move the solid ones to the front and store only those.
+            for (uint32_t i = 0; i < 32; i += 8) {
+                uint32_t solid_mask = (solid_bits >> i) & 0xFF;
+                if (!solid_mask)
+                    continue;
+                __m256i colors  = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&row[x + i]));
+                __m256i xs      = _mm256_add_epi32(_mm256_set1_epi32((int)(x + i)), lanes);
+                __m256i packed  = _mm256_or_si256(_mm256_or_si256(xs, packed_yz), _mm256_slli_epi32(colors, 24));
+                __m256i indices = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)k_vox_solid_voxel_indices[solid_mask]), nibble_shift), nibble_mask);
+                uint32_t num_solid = _vox_count_bits(solid_mask);
+                __m256i store_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)num_solid), lanes);
+                _mm256_maskstore_epi32((int*)output, store_mask, _mm256_permutevar8x32_epi32(packed, indices));
+                output += 4 * num_solid;
+            }
+        }
+        return _vox_encode_solid_voxels_sse2(row, x, end_x, y, z, output);
+    }
+    #endif
+
+    #if defined(_VOX_HAVE_NEON)
+    static uint32_t _vox_count_solid_voxels_neon(const uint8_t* voxels, uint32_t num_voxels) {
+        uint32_t num_solid = 0;
+        uint32_t i = 0;
+        while (i + 16 <= num_voxels) {
+            // each byte of solid_counts can count up to 255 solid voxels before it needs summing.
+            uint8x16_t solid_counts = vdupq_n_u8(0);
+            for (uint32_t j = 0; j < 255 && i + 16 <= num_voxels; j++, i += 16) {
+                uint8x16_t v = vld1q_u8(&voxels[i]);
+                solid_counts = vsubq_u8(solid_counts, vtstq_u8(v, v));
+            }
+            uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(solid_counts)));
+            num_solid += (uint32_t)(vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1));
+        }
+        return num_solid + _vox_count_solid_voxels_scalar(&voxels[i], num_voxels - i);
+    }
+    static uint8_t* _vox_encode_solid_voxels_neon(const uint8_t* row, uint32_t first_x, uint32_t end_x, uint32_t y, uint32_t z, uint8_t* output) {
+        const uint64_t one_bit_per_nibble = ((uint64_t)0x11111111 << 32) | 0x11111111;
+        uint32_t x = first_x;
+        for (; x + 16 <= end_x; x += 16) {
+            // narrowing the solid byte mask by 4 bits leaves a nibble for each voxel.
+            uint8x16_t v = vld1q_u8(&row[x]);
+            uint8x8_t solid_nibbles = vshrn_n_u16(vreinterpretq_u16_u8(vtstq_u8(v, v)), 4);
+            uint64_t solid_bits = vget_lane_u64(vreinterpret_u64_u8(solid_nibbles), 0) & one_bit_per_nibble;
+            output = _vox_encode_solid_voxel_bits(row, x, solid_bits, 2, y, z, output);
+        }
+        return _vox_encode_solid_voxels_scalar(row, x, end_x, y, z, output);
+    }
+    #endif
+
+    // returns the number of solid voxels in voxels.
+    static uint32_t _vox_count_solid_voxels(const uint8_t* voxels, uint32_t num_voxels) {
+    #if defined(_VOX_HAVE_AVX2)
+        if (_vox_cpu_has_avx2())
+            return _vox_count_solid_voxels_avx2(voxels, num_voxels);
+    #endif
+    #if defined(_VOX_HAVE_SSE2)
+        return _vox_count_solid_voxels_sse2(voxels, num_voxels);
+    #elif defined(_VOX_HAVE_NEON)
+        return _vox_count_solid_voxels_neon(voxels, num_voxels);
+    #else
+        return _vox_count_solid_voxels_scalar(voxels, num_voxels);
+    #endif
+    }
+    // writes the solid voxels of a row of a grid to output as packed voxels in x order, and returns the end of the output.
+    static uint8_t* _vox_encode_solid_voxels(const uint8_t* row, uint32_t size_x, uint32_t y, uint32_t z, uint8_t* output) {
+    #if defined(_VOX_HAVE_AVX2)
+        if (_vox_cpu_has_avx2())
+            return _vox_encode_solid_voxels_avx2(row, 0, size_x, y, z, output);
+    #endif
+    #if defined(_VOX_HAVE_SSE2)
+        return _vox_encode_solid_voxels_sse2(row, 0, size_x, y, z, output);
+    #elif defined(_VOX_HAVE_NEON)
+        return _vox_encode_solid_voxels_neon(row, 0, size_x, y, z, output);
+    #else
+        return _vox_encode_solid_voxels_scalar(row, 0, size_x, y, z, output);
+    #endif
+    }
+
+    uint32_t ogt_vox_count_solid_voxels(const uint8_t* voxel_data, uint32_t num_voxels) {
+        return _vox_count_solid_voxels(voxel_data, num_voxels);
+    }
+
+    // minimum number of grid voxels that a single counting or encoding task will process, so tiny models get batched together.
+    static const uint32_t k_vox_min_voxels_per_encode_task = 64 * 1024;
+
+    // when streaming, at most this many bytes of XYZI payloads are encoded at once before being written. A single
+    // model that is larger than this is still encoded in one go.
+    static const uint32_t k_vox_max_encode_batch_size = 4 * 1024 * 1024;
+
+    // splits models [first, end) into tasks that each cover a reasonable amount of voxels, and returns the number of tasks. If
+    // model_indices is non-NULL, [first, end) is a range within model_indices rather than a range of models.
+    static uint32_t _vox_split_models_into_tasks(const ogt_vox_scene* scene, const uint32_t* model_indices, uint32_t first, uint32_t end, _vox_array<uint32_t>& task_first_model) {
+        task_first_model.resize(0);
+        task_first_model.reserve(16);
+        task_first_model.push_back(first);
+        uint32_t task_voxel_count = 0;
+        for (uint32_t i = first; i < end; i++) {
+            const ogt_vox_model* model = scene->models[model_indices ? model_indices[i] : i];
+            task_voxel_count += model->size_x * model->size_y * model->size_z;
+            if (task_voxel_count >= k_vox_min_voxels_per_encode_task || i + 1 == end) {
+                task_first_model.push_back(i + 1);
+                task_voxel_count = 0;
+            }
+        }
+        return (uint32_t)task_first_model.size() - 1;
+    }
+
+    struct _vox_encode_models_task_data {
+        const ogt_vox_scene* scene;
+        const uint32_t*      task_first_model;
+        const uint32_t*      model_indices;       // if non-NULL, the models that tasks refer to, as in _vox_split_models_into_tasks.
+        uint32_t*            num_solid_voxels;    // receives the number of solid voxels in each model when counting.
+        uint8_t* const*      payloads;            // where to encode the XYZI payload of each model. Models with a NULL payload are skipped.
+    };
+
+    // counts the solid voxels of each model in this task.
+    static void _vox_count_models_task(void* _task_data, uint32_t task_index) {
+        const _vox_encode_models_task_data* task_data = (const _vox_encode_models_task_data*)_task_data;
+        const ogt_vox_scene* scene = task_data->scene;
+        for (uint32_t task_model = task_data->task_first_model[task_index]; task_model < task_data->task_first_model[task_index + 1]; task_model++) {
+            const uint32_t i = task_data->model_indices ? task_data->model_indices[task_model] : task_model;
+            const ogt_vox_model* model = scene->models[i];
+            const ogt_vox_sparse_model* sparse_model = ogt_vox_get_sparse_model(scene, i);
+            if (sparse_model) {
+                task_data->num_solid_voxels[i] = sparse_model->num_voxels;
+                continue;
+            }
+            task_data->num_solid_voxels[i] = _vox_count_solid_voxels(model->voxel_data, model->size_x * model->size_y * model->size_z);
+        }
+    }
+
+    // encodes the solid voxels of each model in this task as packed (x,y,z,color_index) voxels in x, then y, then z order.
+    static void _vox_encode_models_task(void* _task_data, uint32_t task_index) {
+        const _vox_encode_models_task_data* task_data = (const _vox_encode_models_task_data*)_task_data;
+        for (uint32_t task_model = task_data->task_first_model[task_index]; task_model < task_data->task_first_model[task_index + 1]; task_model++) {
+            const uint32_t i = task_data->model_indices ? task_data->model_indices[task_model] : task_model;
+            uint8_t* output = task_data->payloads[i];
+            if (!output)
+                continue;
+            const ogt_vox_model* model = task_data->scene->models[i];
+            const uint8_t* voxel_data = model->voxel_data;
+            for (uint32_t z = 0; z < model->size_z; z++) {
+                for (uint32_t y = 0; y < model->size_y; y++, voxel_data += model->size_x)
+                    output = _vox_encode_solid_voxels(voxel_data, model->size_x, y, z, output);
+            }
+        }
+    }
+
+    // what the writer needs to know about a scene beyond what is in the scene itself. It is gathered once, and then used
+    // both to measure the scene and to write it.
+    struct _vox_scene_write_layout {
+        _vox_array<uint32_t> num_solid_voxels;        // the number of solid voxels in each model, which determines the size of its XYZI chunk
+        _vox_array<uint32_t> first_group_child;       // for each group, the index of its first child in group_child_node_ids. Has an extra entry at the end.
+        _vox_array<uint32_t> group_child_node_ids;    // the node ids of the children of all groups, grouped by parent group
+        _vox_array<uint8_t*> encoded_payloads;        // the XYZI payload of each model with a grid, if they were encoded up front by a save session
+    };
+
+    // the encoded XYZI payload of a model, kept by a save session.
+    struct _vox_cached_model {
+        uint32_t voxel_hash;
+        uint32_t size_x;
+        uint32_t size_y;
+        uint32_t size_z;
+        uint32_t num_solid_voxels;
+        uint8_t* payload;       // 4 bytes for each solid voxel. Owned by the save session.
+    };
+
+    // the encoded models of the most recent save.
+    struct ogt_vox_save_session {
+        _vox_array<_vox_cached_model> cached_models;
+        _vox_array<_vox_cached_model> next_cached_models;   // the cache being built by the current save
+        _vox_array<uint32_t>          model_indices;        // scratch memory for the models to encode and the cache lookup tables
+    };
+
+    ogt_vox_save_session* ogt_vox_create_save_session() {
+        // a zeroed _vox_array is an empty array, so zeroed memory is a valid session.
+        return (ogt_vox_save_session*)_vox_calloc(sizeof(ogt_vox_save_session));
+    }
+
+    void ogt_vox_destroy_save_session(ogt_vox_save_session* session) {
+        if (!session)
+            return;
+        for (uint32_t i = 0; i < session->cached_models.size(); i++)
+            _vox_free(session->cached_models[i].payload);
+        session->~ogt_vox_save_session();
+        _vox_free(session);
+    }
+
+    static uint32_t _vox_cached_model_slot(const ogt_vox_model* model, uint32_t mask) {
+        return ((model->voxel_hash ^ (model->size_x << 16) ^ (model->size_y << 8) ^ model->size_z) * 2654435761u) & mask;
+    }
+    // models are matched only by their hash and dimensions, as comparing voxels would make every save cost about as much as
+    // counting all voxels of the scene again.
+    static bool _vox_cached_model_matches(const _vox_cached_model& cached_model, const ogt_vox_model* model) {
+        return cached_model.voxel_hash == model->voxel_hash && cached_model.size_x == model->size_x &&
+            cached_model.size_y == model->size_y && cached_model.size_z == model->size_z;
+    }
+    // returns the index within cached_models of the entry for model, or UINT32_MAX if there isn't one. table is an open-addressed
+    // hash table of mask + 1 slots, where each slot holds an index + 1, or 0 if the slot is empty.
+    static uint32_t _vox_find_cached_model(const _vox_array<_vox_cached_model>& cached_models, uint32_t* table, uint32_t mask, const ogt_vox_model* model, uint32_t& slot) {
+        slot = _vox_cached_model_slot(model, mask);
+        while (table[slot]) {
+            if (_vox_cached_model_matches(cached_models[table[slot] - 1], model))
+                return table[slot] - 1;
+            slot = (slot + 1) & mask;
+        }
+        return UINT32_MAX;
+    }
+
+    // gets the XYZI payload of every model with a grid from the session: models that match one from the previous save reuse
+    // its payload, and all others are counted and encoded across the job system. The session then keeps just these models.
+    // Returns false if memory for a payload couldn't be allocated.
+    static bool _vox_encode_models_with_session(const ogt_vox_scene* scene, ogt_vox_save_session* session, _vox_scene_write_layout& layout) {
+        _vox_array<_vox_cached_model>& cached_models      = session->cached_models;
+        _vox_array<_vox_cached_model>& next_cached_models = session->next_cached_models;
+        _vox_array<uint32_t>&          scratch            = session->model_indices;
+        layout.num_solid_voxels.resize(scene->num_models);
+        layout.encoded_payloads.resize(scene->num_models);
+
+        // the scratch memory holds the lookup tables of the previous and the next cache, and then the models to encode.
+        const uint32_t cached_mask = _vox_hash_table_mask(cached_models.size());
+        const uint32_t next_mask   = _vox_hash_table_mask(scene->num_models);
+        scratch.resize(cached_mask + 1 + next_mask + 1 + scene->num_models);
+        uint32_t* cached_table  = &scratch[0];
+        uint32_t* next_table    = &scratch[cached_mask + 1];
+        uint32_t* model_indices = &scratch[cached_mask + 1 + next_mask + 1];
+        memset(scratch.data, 0, sizeof(uint32_t) * (cached_mask + 1 + next_mask + 1));
+        for (uint32_t i = 0; i < cached_models.size(); i++) {
+            ogt_vox_model key = { cached_models[i].size_x, cached_models[i].size_y, cached_models[i].size_z, cached_models[i].voxel_hash, NULL };
+            uint32_t slot = _vox_cached_model_slot(&key, cached_mask);
+            while (cached_table[slot])
+                slot = (slot + 1) & cached_mask;
+            cached_table[slot] = i + 1;
+        }
+
+        // find each model in the next cache, or else move its entry over from the previous cache, or else add a new entry for it.
+        // layout.num_solid_voxels temporarily holds the index of each model's entry.
+        next_cached_models.resize(0);
+        next_cached_models.reserve(scene->num_models);
+        uint32_t num_models_to_encode = 0;
         for (uint32_t i = 0; i < scene->num_models; i++) {
+            const ogt_vox_model* model = scene->models[i];
+            layout.encoded_payloads[i] = NULL;
+            const ogt_vox_sparse_model* sparse_model = ogt_vox_get_sparse_model(scene, i);
+            if (sparse_model) {
+                layout.num_solid_voxels[i] = UINT32_MAX;
+                continue;
+            }
+            uint32_t next_slot = 0;
+            uint32_t next_index = _vox_find_cached_model(next_cached_models, next_table, next_mask, model, next_slot);
+            if (next_index == UINT32_MAX) {
+                next_index = (uint32_t)next_cached_models.size();
+                next_table[next_slot] = next_index + 1;
+                uint32_t cached_slot = 0;
+                uint32_t cached_index = _vox_find_cached_model(cached_models, cached_table, cached_mask, model, cached_slot);
+                if (cached_index != UINT32_MAX) {
+                    next_cached_models.push_back(cached_models[cached_index]);
+                    cached_models[cached_index].payload = NULL;    // it now belongs to the next cache
+                }
+                else {
+                    _vox_cached_model cached_model = { model->voxel_hash, model->size_x, model->size_y, model->size_z, 0, NULL };
+                    next_cached_models.push_back(cached_model);
+                    model_indices[num_models_to_encode++] = i;
+                }
+            }
+            layout.num_solid_voxels[i] = next_index;
+        }
+        // the models that remain in the previous cache weren't saved this time, so they are forgotten.
+        for (uint32_t i = 0; i < cached_models.size(); i++)
+            _vox_free(cached_models[i].payload);
+        cached_models.resize(0);
+
+        // count and encode the new models. Their entries need the counts first, so that their payloads can be allocated.
+        bool encode_ok = true;
+        if (num_models_to_encode) {
+            _vox_array<uint32_t> task_first_model;
+            _vox_array<uint32_t> num_solid_voxels;
+            num_solid_voxels.resize(scene->num_models);
+            _vox_encode_models_task_data task_data;
+            task_data.scene            = scene;
+            task_data.model_indices    = model_indices;
+            task_data.num_solid_voxels = num_solid_voxels.data;
+            task_data.payloads         = layout.encoded_payloads.data;
+            uint32_t task_count = _vox_split_models_into_tasks(scene, model_indices, 0, num_models_to_encode, task_first_model);
+            task_data.task_first_model = task_first_model.data;
+            _vox_run_tasks(_vox_count_models_task, &task_data, task_count);
+            for (uint32_t i = 0; i < num_models_to_encode; i++) {
+                const uint32_t model_index = model_indices[i];
+                _vox_cached_model& cached_model = next_cached_models[layout.num_solid_voxels[model_index]];
+                cached_model.num_solid_voxels = num_solid_voxels[model_index];
+                cached_model.payload = (uint8_t*)_vox_malloc(4 * cached_model.num_solid_voxels);
+                encode_ok = encode_ok && (cached_model.payload || !cached_model.num_solid_voxels);
+                layout.encoded_payloads[model_index] = cached_model.payload;
+            }
+            _vox_run_tasks(_vox_encode_models_task, &task_data, task_count);
+        }
+
+        // the next cache becomes the cache. Entries for models that failed to allocate are dropped again.
+        for (uint32_t i = 0; i < next_cached_models.size(); i++)
+            if (next_cached_models[i].payload || !next_cached_models[i].num_solid_voxels)
+                cached_models.push_back(next_cached_models[i]);
+        for (uint32_t i = 0; i < scene->num_models; i++) {
+            if (layout.num_solid_voxels[i] == UINT32_MAX) {
+                layout.num_solid_voxels[i] = ogt_vox_get_sparse_model(scene, i)->num_voxels;
+                continue;
+            }
+            const _vox_cached_model& cached_model = next_cached_models[layout.num_solid_voxels[i]];
+            layout.num_solid_voxels[i] = cached_model.num_solid_voxels;
+            layout.encoded_payloads[i] = cached_model.payload;
+        }
+        return encode_ok;
+    }
+
+    // counts the solid voxels of every model, or has the save session encode them if there is one, and builds the child node lists of every group in time linear in the number
+    // of groups and instances: children are counted per parent, the counts are turned into offsets by a prefix sum, and
+    // then every child is placed at its parent's offset. Each group lists its child groups first, then its instances.
+    // Returns false if memory for a model's grid or payload couldn't be allocated.
+    static bool _vox_build_scene_write_layout(const ogt_vox_scene* scene, ogt_vox_save_session* session, _vox_scene_write_layout& layout) {
+        // these must match the node_id ranges in _vox_write_scene.
+        const uint32_t first_group_transform_node_id    = 0;
+        const uint32_t first_instance_transform_node_id = 2 * scene->num_groups + scene->num_models;
+
+        // make sure lazy models have their grid before counting, so that it is only allocated from the calling thread.
+        for (uint32_t i = 0; i < scene->num_models; i++)
+            if (!ogt_vox_get_sparse_model(scene, i) && !ogt_vox_get_model_voxels(scene, i))
+                return false;
+        if (session) {
+            if (!_vox_encode_models_with_session(scene, session, layout))
+                return false;
+        }
+        else {
+            // models are independent, so they are counted across the job system.
+            layout.num_solid_voxels.resize(scene->num_models);
+            _vox_array<uint32_t> task_first_model;
+            _vox_encode_models_task_data task_data;
+            task_data.scene            = scene;
+            task_data.model_indices    = NULL;
+            task_data.num_solid_voxels = layout.num_solid_voxels.data;
+            task_data.payloads         = NULL;
+            uint32_t task_count = _vox_split_models_into_tasks(scene, NULL, 0, scene->num_models, task_first_model);
+            task_data.task_first_model = task_first_model.data;
+            _vox_run_tasks(_vox_count_models_task, &task_data, task_count);
+        }
+
+        // count the children of each group. Children whose parent index isn't a valid group are not written.
+        _vox_array<uint32_t>& first_group_child = layout.first_group_child;
+        first_group_child.resize(scene->num_groups + 1);
+        memset(&first_group_child[0], 0, sizeof(uint32_t) * (scene->num_groups + 1));
+        for (uint32_t i = 0; i < scene->num_groups; i++)
+            if (scene->groups[i].parent_group_index < scene->num_groups)
+                first_group_child[scene->groups[i].parent_group_index]++;
+        for (uint32_t i = 0; i < scene->num_instances; i++)
+            if (scene->instances[i].group_index < scene->num_groups)
+                first_group_child[scene->instances[i].group_index]++;
+        // turn the counts into offsets.
+        uint32_t num_children = 0;
+        for (uint32_t i = 0; i <= scene->num_groups; i++) {
+            uint32_t count = first_group_child[i];
+            first_group_child[i] = num_children;
+            num_children += count;
+        }
+        // place the children, using first_group_child as a cursor for each group. This leaves every entry at the offset of the
+        // next group, so we shift them back down again afterwards.
+        _vox_array<uint32_t>& group_child_node_ids = layout.group_child_node_ids;
+        group_child_node_ids.resize(num_children);
+        for (uint32_t i = 0; i < scene->num_groups; i++)
+            if (scene->groups[i].parent_group_index < scene->num_groups)
+                group_child_node_ids[first_group_child[scene->groups[i].parent_group_index]++] = first_group_transform_node_id + i;
+        for (uint32_t i = 0; i < scene->num_instances; i++)
+            if (scene->instances[i].group_index < scene->num_groups)
+                group_child_node_ids[first_group_child[scene->instances[i].group_index]++] = first_instance_transform_node_id + i;
+        for (uint32_t i = scene->num_groups; i > 0; i--)
+            first_group_child[i] = first_group_child[i - 1];
+        first_group_child[0] = 0;
+        return true;
+    }
+
+    // writes the SIZE and XYZI chunks of models [first_model, end_model). The XYZI payloads of models with a grid are copied
+    // from payloads if payloads_are_encoded is set. Otherwise space is left for them, and payloads receives where that is.
+    static void _vox_write_model_chunks(const ogt_vox_scene* scene, const _vox_scene_write_layout& layout, uint32_t first_model, uint32_t end_model,
+        uint8_t** payloads, bool payloads_are_encoded, _vox_file_writeable* fp)
+    {
+        for (uint32_t i = first_model; i < end_model; i++) {
             const ogt_vox_model* model = scene->models[i];
             assert(model->size_x <= 126 && model->size_y <= 126 && model->size_z <= 126);
-            // count the number of solid voxels in the grid
-            uint32_t num_voxels_in_grid = model->size_x * model->size_y * model->size_z;
-            uint32_t num_solid_voxels = 0;
-            for (uint32_t voxel_index = 0; voxel_index < num_voxels_in_grid; voxel_index++)
-                if (model->voxel_data[voxel_index] != 0)
-                    num_solid_voxels++;
+            const ogt_vox_sparse_model* sparse_model = ogt_vox_get_sparse_model(scene, i);
+            uint32_t num_solid_voxels = layout.num_solid_voxels[i];
             uint32_t chunk_size_xyzi = sizeof(uint32_t) + 4 * num_solid_voxels;
 
-            // write the SIZE chunk header 
+            // write the SIZE chunk header
             _vox_file_write_uint32(fp, CHUNK_ID_SIZE);
             _vox_file_write_uint32(fp, 12);
             _vox_file_write_uint32(fp, 0);
@@ -1651,21 +3608,92 @@
 
             // write out XYZI chunk payload
             _vox_file_write_uint32(fp, num_solid_voxels);
-            uint32_t voxel_index = 0;
-            for (uint32_t z = 0; z < model->size_z; z++) {
-                for (uint32_t y = 0; y < model->size_y; y++) {
-                    for (uint32_t x = 0; x < model->size_x; x++, voxel_index++) {
-                        uint8_t color_index = model->voxel_data[voxel_index];
-                        if (color_index != 0) {
-                            _vox_file_write_uint8(fp, (uint8_t)x);
-                            _vox_file_write_uint8(fp, (uint8_t)y);
-                            _vox_file_write_uint8(fp, (uint8_t)z);
-                            _vox_file_write_uint8(fp, color_index);
-                        }
-                    }
-                }
+            if (sparse_model) {
+                // sparse models already have their solid voxels in the order we write them.
+                _vox_file_write(fp, sparse_model->voxels, sizeof(ogt_vox_packed_voxel) * num_solid_voxels);
+            }
+            else if (payloads_are_encoded) {
+                _vox_file_write(fp, payloads[i], 4 * num_solid_voxels);
+            }
+            else {
+                payloads[i] = _vox_file_reserve(fp, 4 * num_solid_voxels);
+                _vox_file_commit(fp, 4 * num_solid_voxels);
             }
         }
+    }
+
+    // writes the SIZE and XYZI chunks of all models. Models are independent, so their XYZI payloads are encoded across the
+    // job system: straight into place if the whole output is a single buffer, otherwise in batches that are then streamed
+    // out in order. Either way, the output is identical to encoding them one after another.
+    static void _vox_write_models(const ogt_vox_scene* scene, const _vox_scene_write_layout& layout, _vox_file_writeable* fp) {
+        if (layout.encoded_payloads.size()) {
+            _vox_write_model_chunks(scene, layout, 0, scene->num_models, layout.encoded_payloads.data, true, fp);
+            return;
+        }
+        _vox_array<uint8_t*> payloads;
+        payloads.resize(scene->num_models);
+        for (uint32_t i = 0; i < scene->num_models; i++)
+            payloads[i] = NULL;
+        _vox_array<uint32_t> task_first_model;
+        _vox_encode_models_task_data task_data;
+        task_data.scene            = scene;
+        task_data.model_indices    = NULL;
+        task_data.num_solid_voxels = NULL;
+        task_data.payloads         = payloads.data;
+
+        // when measuring, the payload sizes are all that matters. When the output is a single buffer, every payload can be
+        // encoded straight into the space that was left for it.
+        if (_vox_file_is_counting(fp) || !fp->write_func) {
+            _vox_write_model_chunks(scene, layout, 0, scene->num_models, payloads.data, false, fp);
+            if (_vox_file_is_counting(fp))
+                return;
+            uint32_t task_count = _vox_split_models_into_tasks(scene, NULL, 0, scene->num_models, task_first_model);
+            task_data.task_first_model = task_first_model.data;
+            _vox_run_tasks(_vox_encode_models_task, &task_data, task_count);
+            return;
+        }
+
+        // otherwise, payloads are encoded into a batch before being streamed out.
+        _vox_array<uint8_t> batch;
+        for (uint32_t first_model = 0, end_model = 0; first_model < scene->num_models; first_model = end_model) {
+            // gather consecutive models until their payloads fill a batch, then give each payload its place in the batch.
+            uint32_t batch_size = 0;
+            do {
+                uint32_t payload_size = ogt_vox_get_sparse_model(scene, end_model) ? 0 : 4 * layout.num_solid_voxels[end_model];
+                if (end_model > first_model && batch_size + payload_size > k_vox_max_encode_batch_size)
+                    break;
+                batch_size += payload_size;
+                end_model++;
+            } while (end_model < scene->num_models);
+            batch.resize(batch_size);
+            for (uint32_t i = first_model, offset = 0; i < end_model; i++) {
+                if (ogt_vox_get_sparse_model(scene, i))
+                    continue;
+                payloads[i] = batch.data + offset;
+                offset += 4 * layout.num_solid_voxels[i];
+            }
+
+            uint32_t task_count = _vox_split_models_into_tasks(scene, NULL, first_model, end_model, task_first_model);
+            task_data.task_first_model = task_first_model.data;
+            _vox_run_tasks(_vox_encode_models_task, &task_data, task_count);
+            _vox_write_model_chunks(scene, layout, first_model, end_model, payloads.data, true, fp);
+        }
+    }
+
+    // writes the scene to fp. main_chunk_child_size must be the size of everything after the MAIN chunk header, which
+    // is measured by writing the scene once with a counting fp first.
+    static void _vox_write_scene(const ogt_vox_scene* scene, const _vox_scene_write_layout& layout, uint32_t main_chunk_child_size, _vox_file_writeable* fp) {
+        // write file header and file version
+        _vox_file_write_uint32(fp, CHUNK_ID_VOX_);
+        _vox_file_write_uint32(fp, 150);
+
+        // write the main chunk
+        _vox_file_write_uint32(fp, CHUNK_ID_MAIN);
+        _vox_file_write_uint32(fp, 0);
+        _vox_file_write_uint32(fp, main_chunk_child_size);
+
+        // write out all model chunks
+        _vox_write_models(scene, layout, fp);
 
         // define our node_id ranges.
         assert(scene->num_groups);
@@ -1681,15 +3709,8 @@
         }
         // write the group nodes for each of the groups in the scene
         for (uint32_t group_index = 0; group_index < scene->num_groups; group_index++) {
-            // count how many childnodes  there are. This is simply the sum of all 
-            // groups and instances that have this group as its parent 
-            uint32_t num_child_nodes = 0;
-            for (uint32_t child_group_index = 0; child_group_index < scene->num_groups; child_group_index++)
-                if (scene->groups[child_group_index].parent_group_index == group_index)
-                    num_child_nodes++;
-            for (uint32_t child_instance_index = 0; child_instance_index < scene->num_instances; child_instance_index++)
-                if (scene->instances[child_instance_index].group_index == group_index)
-                    num_child_nodes++;
+            const uint32_t first_child     = layout.first_group_child[group_index];
+            const uint32_t num_child_nodes = layout.first_group_child[group_index + 1] - first_child;
 
             // count number of dictionary items
             const char* hidden_string = scene->groups[group_index].hidden ? "1" : NULL;
@@ -1712,14 +3733,9 @@
             _vox_file_write_uint32(fp, group_dict_keyvalue_count); // num keyvalue pairs in node dictionary
             _vox_file_write_dict_key_value(fp, "_hidden", hidden_string);
             _vox_file_write_uint32(fp, num_child_nodes);
-            // write the child group transform nodes
-            for (uint32_t child_group_index = 0; child_group_index < scene->num_groups; child_group_index++)
-                if (scene->groups[child_group_index].parent_group_index == group_index)
-                    _vox_file_write_uint32(fp, first_group_transform_node_id + child_group_index);
-            // write the child instance transform nodes
-            for (uint32_t child_instance_index = 0; child_instance_index < scene->num_instances; child_instance_index++)
-                if (scene->instances[child_instance_index].group_index == group_index)
-                    _vox_file_write_uint32(fp, first_instance_transform_node_id + child_instance_index);
+            // write the child group transform nodes, then the child instance transform nodes
+            if (num_child_nodes)
+                _vox_file_write(fp, &layout.group_child_node_ids[first_child], sizeof(uint32_t) * num_child_nodes);
         }
 
         // write out an nSHP chunk for each of the models
@@ -1787,22 +3803,124 @@
             _vox_file_write_dict_key_value(fp, "_hidden", hidden_string);
             _vox_file_write_uint32(fp, UINT32_MAX);                 // reserved id
         }
-        
-        // we deliberately don't free the fp->data field, just pass the buffer pointer and size out to the caller
-        *buffer_size = (uint32_t)fp->data.count;
-        uint8_t* buffer_data = _vox_file_get_data(fp);
-        // we deliberately clear this pointer so it doesn't get auto-freed on exiting. The caller will own the memory hereafter.
-        fp->data.data = NULL;
+    }
 
-        // patch up the main chunk's child chunk size now that we've written everything we're going to write.
-        {
-            uint32_t* main_chunk_child_size = (uint32_t*)& buffer_data[offset_post_main_chunk - sizeof(uint32_t)];
-            *main_chunk_child_size = *buffer_size - offset_post_main_chunk;
-        }
+    // the size of everything up to and including the MAIN chunk header.
+    static const uint32_t k_vox_main_chunk_children_offset = 20;
 
+    // returns the size of the written scene, or 0 if a model's grid or the save session ran out of memory. layout receives everything else that
+    // is needed to write it.
+    static uint32_t _vox_measure_scene(const ogt_vox_scene* scene, ogt_vox_save_session* session, _vox_scene_write_layout& layout) {
+        if (!_vox_build_scene_write_layout(scene, session, layout))
+            return 0;
+        _vox_file_writeable counter;
+        _vox_file_writeable_init(&counter, NULL, 0, NULL, NULL);
+        _vox_write_scene(scene, layout, 0, &counter);
+        return _vox_file_get_offset(&counter);
+    }
+
+    // measures the scene, then writes it to fp.
+    static bool _vox_measure_and_write_scene(const ogt_vox_scene* scene, ogt_vox_save_session* session, _vox_file_writeable* fp) {
+        _vox_scene_write_layout layout;
+        const uint32_t size = _vox_measure_scene(scene, session, layout);
+        if (!size)
+            return false;
+        _vox_write_scene(scene, layout, size - k_vox_main_chunk_children_offset, fp);
+        _vox_file_flush(fp);
+        assert(fp->failed || _vox_file_get_offset(fp) == size);
+        return !fp->failed;
+    }
+
+    // writes the scene through write_func in blocks of k_vox_write_block_size.
+    static bool _vox_write_scene_in_blocks(const ogt_vox_scene* scene, ogt_vox_save_session* session, ogt_vox_write_func write_func, void* user_data) {
+        uint8_t* block = (uint8_t*)_vox_malloc(k_vox_write_block_size);
+        if (!block)
+            return false;
+        _vox_file_writeable file;
+        _vox_file_writeable_init(&file, block, k_vox_write_block_size, write_func, user_data);
+        bool write_ok = _vox_measure_and_write_scene(scene, session, &file);
+        _vox_free(block);
+        return write_ok;
+    }
+
+    bool ogt_vox_write_scene_to_func(const ogt_vox_scene* scene, ogt_vox_write_func write_func, void* user_data) {
+        return _vox_write_scene_in_blocks(scene, NULL, write_func, user_data);
+    }
+
+    static bool _vox_write_to_stdio_file(const void* data, uint32_t data_size, void* user_data) {
+        return fwrite(data, data_size, 1, (FILE*)user_data) == 1;
+    }
+
+    static bool _vox_write_scene_to_file(const ogt_vox_scene* scene, ogt_vox_save_session* session, const char* filename) {
+    #if defined(_MSC_VER) && _MSC_VER >= 1400
+        FILE* fp;
+        if (0 != fopen_s(&fp, filename, "wb"))
+            fp = 0;
+    #else
+        FILE* fp = fopen(filename, "wb");
+    #endif
+        if (!fp)
+            return false;
+        bool write_ok = _vox_write_scene_in_blocks(scene, session, _vox_write_to_stdio_file, fp);
+        return (fclose(fp) == 0) && write_ok;
+    }
+
+    bool ogt_vox_write_scene_to_file(const ogt_vox_scene* scene, const char* filename) {
+        return _vox_write_scene_to_file(scene, NULL, filename);
+    }
+
+    bool ogt_vox_write_scene_to_file_with_session(ogt_vox_save_session* session, const ogt_vox_scene* scene, const char* filename) {
+        assert(session);
+        return _vox_write_scene_to_file(scene, session, filename);
+    }
+
+    // writes a scene of the measured size into a buffer of at least that size.
+    static void _vox_write_measured_scene_to_buffer(const ogt_vox_scene* scene, const _vox_scene_write_layout& layout, uint32_t size, uint8_t* buffer) {
+        _vox_file_writeable file;
+        _vox_file_writeable_init(&file, buffer, size, NULL, NULL);
+        _vox_write_scene(scene, layout, size - k_vox_main_chunk_children_offset, &file);
+        assert(!file.failed && _vox_file_get_offset(&file) == size);
+    }
+
+    uint32_t ogt_vox_write_scene_size(const ogt_vox_scene* scene) {
+        _vox_scene_write_layout layout;
+        return _vox_measure_scene(scene, NULL, layout);
+    }
+
+    uint32_t ogt_vox_write_scene_to_buffer(const ogt_vox_scene* scene, uint8_t* buffer, uint32_t buffer_size) {
+        _vox_scene_write_layout layout;
+        const uint32_t size = _vox_measure_scene(scene, NULL, layout);
+        if (size > buffer_size)
+            return 0;
+        _vox_write_measured_scene_to_buffer(scene, layout, size, buffer);
+        return size;
+    }
+
+    // writes the scene to a new buffer of exactly the right size.
+    static uint8_t* _vox_write_scene_to_new_buffer(const ogt_vox_scene* scene, ogt_vox_save_session* session, uint32_t* buffer_size) {
+        // measure the scene first so the buffer can be allocated once at exactly the right size.
+        _vox_scene_write_layout layout;
+        const uint32_t size = _vox_measure_scene(scene, session, layout);
+        *buffer_size = 0;
+        uint8_t* buffer_data = (uint8_t*)_vox_malloc(size);
+        if (!buffer_data)
+            return NULL;
+        _vox_write_measured_scene_to_buffer(scene, layout, size, buffer_data);
+        // the caller owns the buffer hereafter.
+        *buffer_size = size;
         return buffer_data;
     }
-    
+
+    // saves the scene out to a buffer that when saved as a .vox file can be loaded with magicavoxel.
+    uint8_t* ogt_vox_write_scene(const ogt_vox_scene* scene, uint32_t* buffer_size) {
+        return _vox_write_scene_to_new_buffer(scene, NULL, buffer_size);
+    }
+
+    uint8_t* ogt_vox_write_scene_with_session(ogt_vox_save_session* session, const ogt_vox_scene* scene, uint32_t* buffer_size) {
+        assert(session);
+        return _vox_write_scene_to_new_buffer(scene, session, buffer_size);
+    }
+
     void* ogt_vox_malloc(size_t size) {
         return _vox_malloc(size);
     }
@@ -1861,52 +3979,196 @@
         memset(used_mask, 0, 256);
         for (uint32_t model_index = 0; model_index < scene->num_models; model_index++) {
             const ogt_vox_model* model = scene->models[model_index];
+            const uint8_t* voxel_data = ogt_vox_get_model_voxels(scene, model_index);
             uint32_t voxel_count = model->size_x * model->size_y * model->size_z;
             for (uint32_t voxel_index = 0; voxel_index < voxel_count; voxel_index++) {
-                uint8_t color_index = model->voxel_data[voxel_index];
+                uint8_t color_index = voxel_data[voxel_index];
                 used_mask[color_index] = true;
             }
         }
     }
 
+    // packs the r,g,b components of a color into the key used by the palette lookup tables.
+    static inline uint32_t _vox_rgb_key(const ogt_vox_rgba color) {
+        return (uint32_t)color.r | ((uint32_t)color.g << 8) | ((uint32_t)color.b << 16);
+    }
+
+    // spreads an rgb key across the low bits that the palette lookup tables mask off.
+    static inline uint32_t _vox_rgb_key_hash(uint32_t key) {
+        uint32_t hash = key * 2654435761u;
+        return hash ^ (hash >> 16);
+    }
+
+    static const uint32_t k_vox_palette_exact_slot_count = 512;      // at least twice the number of colors in a palette.
+    static const uint32_t k_vox_palette_min_nearest_slot_count = 1024;
+
+    // lookup structures for the master palette of a merge, shared by all scenes being merged. Colors are only ever
+    // appended to the master palette, so the exact table is updated as they are added, while the nearest color
+    // structures are only built once the palette is full and can no longer change.
+    struct _vox_palette_lookup {
+        _vox_palette_lookup() : num_sorted_indices(0), num_nearest(0) {
+            memset(exact_slots, 0, sizeof(exact_slots));
+        }
+        uint32_t exact_slots[k_vox_palette_exact_slot_count];   // first master index with a given rgb plus one, 0 if empty.
+        uint8_t  sorted_indices[256];                           // master indices ordered by red, then by index.
+        uint32_t num_sorted_indices;                            // 0 until the nearest color search is prepared.
+        _vox_array<uint32_t> nearest_slots;                     // (rgb key << 8) | closest master index, 0 if empty.
+        uint32_t num_nearest;
+    };
+
+    // records the color that was just appended to the master palette at master_index.
+    static void add_color_to_palette_lookup(_vox_palette_lookup & lookup, const ogt_vox_rgba * palette, uint32_t master_index) {
+        assert(lookup.num_sorted_indices == 0); // the palette must not change once nearest color searches have started.
+        const uint32_t key  = _vox_rgb_key(palette[master_index]);
+        const uint32_t mask = k_vox_palette_exact_slot_count - 1;
+        uint32_t slot = _vox_rgb_key_hash(key) & mask;
+        while (lookup.exact_slots[slot]) {
+            // exact matches resolve to the lowest index, so an earlier index with the same rgb wins.
+            if (_vox_rgb_key(palette[lookup.exact_slots[slot] - 1]) == key)
+                return;
+            slot = (slot + 1) & mask;
+        }
+        lookup.exact_slots[slot] = master_index + 1;
+    }
+
     // finds an exact color in the specified palette if it exists, and UINT32_MAX otherwise
-    static uint32_t find_exact_color_in_palette(const ogt_vox_rgba * palette, uint32_t palette_count, const ogt_vox_rgba color_to_find) {
-        for (uint32_t color_index = 1; color_index < palette_count; color_index++) {
-            const ogt_vox_rgba color_to_match = palette[color_index];
-            // we only try to match r,g,b components exactly.
-            if (color_to_match.r == color_to_find.r && color_to_match.g == color_to_find.g && color_to_match.b == color_to_find.b)
+    static uint32_t find_exact_color_in_palette(const _vox_palette_lookup & lookup, const ogt_vox_rgba * palette, const ogt_vox_rgba color_to_find) {
+        // we only try to match r,g,b components exactly.
+        const uint32_t key  = _vox_rgb_key(color_to_find);
+        const uint32_t mask = k_vox_palette_exact_slot_count - 1;
+        for (uint32_t slot = _vox_rgb_key_hash(key) & mask; lookup.exact_slots[slot]; slot = (slot + 1) & mask) {
+            uint32_t color_index = lookup.exact_slots[slot] - 1;
+            if (_vox_rgb_key(palette[color_index]) == key)
                 return color_index;
         }
         // no exact color found
         return UINT32_MAX;
     }
 
-    // finds the index within the specified palette that is closest to the color we want to find
-    static uint32_t find_closest_color_in_palette(const ogt_vox_rgba * palette, uint32_t palette_count, const ogt_vox_rgba color_to_find) {
+    // sorts the palette indices by their red component so nearest color searches can stop early.
+    static void prepare_palette_lookup_for_nearest(_vox_palette_lookup & lookup, const ogt_vox_rgba * palette, uint32_t palette_count) {
+        uint32_t num_sorted = 0;
+        for (uint32_t color_index = 1; color_index < palette_count; color_index++) {
+            // insertion sort, which keeps entries with equal red in ascending index order.
+            uint32_t insert_at = num_sorted;
+            while (insert_at > 0 && palette[lookup.sorted_indices[insert_at - 1]].r > palette[color_index].r) {
+                lookup.sorted_indices[insert_at] = lookup.sorted_indices[insert_at - 1];
+                insert_at--;
+            }
+            lookup.sorted_indices[insert_at] = (uint8_t)color_index;
+            num_sorted++;
+        }
+        lookup.num_sorted_indices = num_sorted;
+    }
+
+    // scores a single palette entry against the color to find, keeping it if it beats the best so far. Ties go to the
+    // lowest index so the result is the same as scanning the palette in index order.
+    static inline void score_closest_color_candidate(const ogt_vox_rgba * palette, uint32_t color_index, const ogt_vox_rgba color_to_find, int32_t & best_score, uint32_t & best_index) {
+        int32_t r_diff = (int32_t)color_to_find.r - (int32_t)palette[color_index].r;
+        int32_t g_diff = (int32_t)color_to_find.g - (int32_t)palette[color_index].g;
+        int32_t b_diff = (int32_t)color_to_find.b - (int32_t)palette[color_index].b;
+        // There are 2 aspects of our treatment of color here you may want to experiment with:
+        // 1. differences in R, differences in G, differences in B are weighted the same rather than perceptually. Different weightings may be better for you.
+        // 2. We treat R,G,B as if they are in a perceptually linear within each channel. eg. the differences between
+        //    a value of 5 and 8 in any channel is perceptually the same as the difference between 233 and 236 in the same channel.
+        int32_t score = (r_diff * r_diff) + (g_diff * g_diff) + (b_diff * b_diff);
+        if (score < best_score || (score == best_score && color_index < best_index)) {
+            best_score = score;
+            best_index = color_index;
+        }
+    }
+
+    // searches the palette for the closest color, walking outward from the red component of the color to find.
+    static uint32_t search_closest_color_in_palette(const _vox_palette_lookup & lookup, const ogt_vox_rgba * palette, const ogt_vox_rgba color_to_find) {
         // the lower the score the better, so initialize this to the maximum possible score
         int32_t  best_score = INT32_MAX;
         uint32_t best_index = 1;
-        // Here we compute a score based on the pythagorean distance between each color in the palette and the color to find.
-        // The distance is in R,G,B space, and we choose the color with the lowest score.
-        for (uint32_t color_index = 1; color_index < palette_count; color_index++) {
-            int32_t r_diff = (int32_t)color_to_find.r - (int32_t)palette[color_index].r;
-            int32_t g_diff = (int32_t)color_to_find.g - (int32_t)palette[color_index].g;
-            int32_t b_diff = (int32_t)color_to_find.b - (int32_t)palette[color_index].b;
-            // There are 2 aspects of our treatment of color here you may want to experiment with:
-            // 1. differences in R, differences in G, differences in B are weighted the same rather than perceptually. Different weightings may be better for you.
-            // 2. We treat R,G,B as if they are in a perceptually linear within each channel. eg. the differences between 
-            //    a value of 5 and 8 in any channel is perceptually the same as the difference between 233 and 236 in the same channel.
-            int32_t score = (r_diff * r_diff) + (g_diff * g_diff) + (b_diff * b_diff);
-            if (score < best_score) {
-                best_score = score;
-                best_index = color_index;
-            }
-        }
-        assert(best_score < UINT32_MAX); // this might indicate a completely degenerate palette.
+        // binary search for the first sorted entry with red at or above the color we want to find.
+        const uint8_t* sorted = lookup.sorted_indices;
+        uint32_t first = 0, end = lookup.num_sorted_indices;
+        while (first < end) {
+            uint32_t middle = (first + end) >> 1;
+            if (palette[sorted[middle]].r < color_to_find.r)
+                first = middle + 1;
+            else
+                end = middle;
+        }
+        // the red difference alone is a lower bound on the score, so once it exceeds the best score, no further
+        // entry in that direction can win or tie.
+        for (uint32_t i = first; i < lookup.num_sorted_indices; i++) {
+            int32_t r_diff = (int32_t)palette[sorted[i]].r - (int32_t)color_to_find.r;
+            if (r_diff * r_diff > best_score)
+                break;
+            score_closest_color_candidate(palette, sorted[i], color_to_find, best_score, best_index);
+        }
+        for (uint32_t i = first; i > 0; i--) {
+            int32_t r_diff = (int32_t)color_to_find.r - (int32_t)palette[sorted[i - 1]].r;
+            if (r_diff * r_diff > best_score)
+                break;
+            score_closest_color_candidate(palette, sorted[i - 1], color_to_find, best_score, best_index);
+        }
+        assert(best_score < INT32_MAX || lookup.num_sorted_indices == 0); // this might indicate a completely degenerate palette.
         return best_index;
     }
 
-    static void update_master_palette_from_scene(ogt_vox_rgba * master_palette, uint32_t & master_palette_count, const ogt_vox_scene * scene, uint32_t * scene_to_master_map) {
+    // finds the index within the specified palette that is closest to the color we want to find. Results are cached
+    // per rgb, so scenes that share colors only pay for the search once per merge.
+    static uint32_t find_closest_color_in_palette(_vox_palette_lookup & lookup, const ogt_vox_rgba * palette, uint32_t palette_count, const ogt_vox_rgba color_to_find) {
+        if (lookup.num_sorted_indices == 0)
+            prepare_palette_lookup_for_nearest(lookup, palette, palette_count);
+        assert(lookup.num_sorted_indices == palette_count - 1);
+
+        const uint32_t key = _vox_rgb_key(color_to_find);
+        if (lookup.nearest_slots.count) {
+            const uint32_t mask = (uint32_t)lookup.nearest_slots.count - 1;
+            for (uint32_t slot = _vox_rgb_key_hash(key) & mask; lookup.nearest_slots[slot]; slot = (slot + 1) & mask) {
+                if ((lookup.nearest_slots[slot] >> 8) == key)
+                    return lookup.nearest_slots[slot] & 255;
+            }
+        }
+
+        uint32_t best_index = search_closest_color_in_palette(lookup, palette, color_to_find);
+
+        // keep the cache at most half full, rehashing into a table twice the size when it would exceed that.
+        if ((lookup.num_nearest + 1) * 2 > lookup.nearest_slots.count) {
+            uint32_t old_slot_count = (uint32_t)lookup.nearest_slots.count;
+            uint32_t new_slot_count = old_slot_count ? old_slot_count * 2 : k_vox_palette_min_nearest_slot_count;
+            uint32_t* old_slots = lookup.nearest_slots.data;
+            lookup.nearest_slots.data     = NULL;
+            lookup.nearest_slots.capacity = 0;
+            lookup.nearest_slots.resize(new_slot_count);
+            memset(lookup.nearest_slots.data, 0, sizeof(uint32_t) * new_slot_count);
+            for (uint32_t i = 0; i < old_slot_count; i++) {
+                if (!old_slots[i])
+                    continue;
+                uint32_t slot = _vox_rgb_key_hash(old_slots[i] >> 8) & (new_slot_count - 1);
+                while (lookup.nearest_slots[slot])
+                    slot = (slot + 1) & (new_slot_count - 1);
+                lookup.nearest_slots[slot] = old_slots[i];
+            }
+            _vox_free(old_slots);
+        }
+        const uint32_t mask = (uint32_t)lookup.nearest_slots.count - 1;
+        uint32_t slot = _vox_rgb_key_hash(key) & mask;
+        while (lookup.nearest_slots[slot])
+            slot = (slot + 1) & mask;
+        lookup.nearest_slots[slot] = (key << 8) | best_index;   // best_index is never 0, so an occupied slot is never 0.
+        lookup.num_nearest++;
+        return best_index;
+    }
+
+    static void update_master_palette_from_scene(ogt_vox_rgba * master_palette, uint32_t & master_palette_count, _vox_palette_lookup & master_lookup, const ogt_vox_scene * scene, uint32_t * scene_to_master_map) {
+        // if every scene color is already at the same index in the master palette, eg. because the scene palette was passed
+        // as the required colors, the map is the identity whichever colors the scene uses, so its voxels needn't be scanned.
+        bool is_identity = true;
+        for (uint32_t color_index = 1; color_index < 256 && is_identity; color_index++)
+            is_identity = find_exact_color_in_palette(master_lookup, master_palette, scene->palette.color[color_index]) == color_index;
+        if (is_identity) {
+            for (uint32_t i = 0; i < 256; i++)
+                scene_to_master_map[i] = i;
+            return;
+        }
+
         // compute the mask of used colors in the scene.
         bool scene_used_mask[256];
         compute_scene_used_color_index_mask(scene_used_mask, scene);
@@ -1921,26 +4183,21 @@
             if (scene_used_mask[color_index]) {
                 const ogt_vox_rgba color = scene->palette.color[color_index];
                 // find the exact color in the master palette. Will be UINT32_MAX if the color doesn't already exist
-                uint32_t master_index = find_exact_color_in_palette(master_palette, master_palette_count, color);
+                uint32_t master_index = find_exact_color_in_palette(master_lookup, master_palette, color);
                 if (master_index == UINT32_MAX) {
                     if (master_palette_count < 256) {
                         // master palette capacity hasn't been exceeded so far, allocate the color to it.
                         master_palette[master_palette_count] = color;
                         master_index = master_palette_count++;
+                        add_color_to_palette_lookup(master_lookup, master_palette, master_index);
                     }
                     else {
                         // otherwise, find the color that is perceptually closest to the original color.
 
-                        // TODO(jpaver): It is potentially problematic if we hit this path for a many-scene merge.
-                        // Earlier scenes will reserve their colors exactly into the master palette, whereas later
-                        // scenes will end up having some of their colors remapped to different colors.
-
-                        // A more holistic approach to color allocation may be necessary here eg.
-                        // we might allow the master palette to grow to more than 256 entries, and then use 
-                        // similarity/frequency metrics to reduce the palette from that down to 256 entries. This 
-                        // will mean all scenes will have be equally important if they have a high-frequency
-                        // usage of a color.
-                        master_index = find_closest_color_in_palette(master_palette, master_palette_count, color);
+                        // Note that for a many-scene merge, earlier scenes reserve their colors exactly into the master
+                        // palette, whereas later scenes end up having some of their colors remapped to different colors.
+                        // k_merge_scene_flags_weighted_palette avoids that via build_weighted_master_palette.
+                        master_index = find_closest_color_in_palette(master_lookup, master_palette, master_palette_count, color);
                     }
                 }
                 // caller needs to know how to map its original color index into the master palette
@@ -1949,15 +4206,279 @@
         }
     }
 
+    // a distinct color used by the scenes of a merge, and how many voxels use it across all of them.
+    struct _vox_weighted_color {
+        ogt_vox_rgba color;     // alpha comes from the first scene palette entry with this rgb.
+        uint64_t     weight;
+    };
+
+    // a range of weighted colors that median cut reduces to a single palette color.
+    struct _vox_color_box {
+        uint32_t first;
+        uint32_t end;
+        double   error;         // weighted sum of squared distances to the box mean, or 0 if the box can't be split.
+        uint32_t split_channel; // the channel with the most weighted variance: 0, 1, 2 for r, g, b.
+    };
+
+    static inline uint8_t _vox_color_channel(const ogt_vox_rgba color, uint32_t channel) {
+        return channel == 0 ? color.r : (channel == 1 ? color.g : color.b);
+    }
+
+    // computes the error of a box and the channel to split it along.
+    static void _vox_analyze_color_box(const _vox_weighted_color* colors, _vox_color_box & box) {
+        box.error = 0.0;
+        box.split_channel = 0;
+        if (box.end - box.first < 2)
+            return;
+        double total_weight = 0.0;
+        double mean[3] = { 0.0, 0.0, 0.0 };
+        for (uint32_t i = box.first; i < box.end; i++) {
+            double weight = (double)colors[i].weight;
+            total_weight += weight;
+            for (uint32_t channel = 0; channel < 3; channel++)
+                mean[channel] += weight * _vox_color_channel(colors[i].color, channel);
+        }
+        double variance[3] = { 0.0, 0.0, 0.0 };
+        for (uint32_t channel = 0; channel < 3; channel++)
+            mean[channel] /= total_weight;
+        for (uint32_t i = box.first; i < box.end; i++) {
+            double weight = (double)colors[i].weight;
+            for (uint32_t channel = 0; channel < 3; channel++) {
+                double diff = _vox_color_channel(colors[i].color, channel) - mean[channel];
+                variance[channel] += weight * diff * diff;
+            }
+        }
+        for (uint32_t channel = 0; channel < 3; channel++) {
+            box.error += variance[channel];
+            if (variance[channel] > variance[box.split_channel])
+                box.split_channel = channel;
+        }
+    }
+
+    // sorts a box along its split channel and splits it where half of its weight is on either side.
+    static uint32_t _vox_split_color_box(_vox_weighted_color* colors, _vox_weighted_color* scratch, const _vox_color_box & box) {
+        // counting sort on the channel value, which is stable so ties keep the order the colors were first seen in.
+        uint32_t offsets[257];
+        memset(offsets, 0, sizeof(offsets));
+        uint64_t total_weight = 0;
+        for (uint32_t i = box.first; i < box.end; i++) {
+            offsets[_vox_color_channel(colors[i].color, box.split_channel) + 1]++;
+            total_weight += colors[i].weight;
+        }
+        for (uint32_t value = 0; value < 256; value++)
+            offsets[value + 1] += offsets[value];
+        for (uint32_t i = box.first; i < box.end; i++)
+            scratch[offsets[_vox_color_channel(colors[i].color, box.split_channel)]++] = colors[i];
+        memcpy(&colors[box.first], scratch, sizeof(_vox_weighted_color) * (box.end - box.first));
+
+        // split after the color that brings the weight on the first side to at least half, leaving both sides non-empty.
+        uint64_t first_side_weight = 0;
+        uint32_t split = box.first;
+        while (split < box.end - 1) {
+            first_side_weight += colors[split++].weight;
+            if (first_side_weight * 2 >= total_weight)
+                break;
+        }
+        return split;
+    }
+
+    // reduces colors to at most max_colors palette colors with a median cut weighted by how often each color is used,
+    // and writes them to palette. Returns the number of palette colors written.
+    static uint32_t _vox_median_cut_colors(_vox_weighted_color* colors, uint32_t num_colors, ogt_vox_rgba* palette, uint32_t max_colors) {
+        if (!num_colors || !max_colors)
+            return 0;
+        _vox_array<_vox_weighted_color> scratch;
+        _vox_array<_vox_color_box> boxes;
+        scratch.resize(num_colors);
+        boxes.reserve(max_colors);
+        _vox_color_box all_colors_box;
+        all_colors_box.first = 0;
+        all_colors_box.end   = num_colors;
+        _vox_analyze_color_box(colors, all_colors_box);
+        boxes.push_back(all_colors_box);
+
+        // repeatedly split the box with the most error. Boxes with a single color have none and are never split.
+        while (boxes.size() < max_colors) {
+            uint32_t box_to_split = 0;
+            for (uint32_t i = 1; i < boxes.size(); i++) {
+                if (boxes[i].error > boxes[box_to_split].error)
+                    box_to_split = i;
+            }
+            if (boxes[box_to_split].error <= 0.0)
+                break;
+            _vox_color_box second_box = boxes[box_to_split];
+            uint32_t split = _vox_split_color_box(colors, scratch.data, boxes[box_to_split]);
+            boxes[box_to_split].end = split;
+            second_box.first = split;
+            _vox_analyze_color_box(colors, boxes[box_to_split]);
+            _vox_analyze_color_box(colors, second_box);
+            boxes.push_back(second_box);
+        }
+
+        // each box becomes the weighted mean of its colors, with the alpha of its most used color.
+        for (uint32_t box_index = 0; box_index < boxes.size(); box_index++) {
+            const _vox_color_box & box = boxes[box_index];
+            uint64_t total_weight = 0, sum_r = 0, sum_g = 0, sum_b = 0;
+            uint32_t most_used = box.first;
+            for (uint32_t i = box.first; i < box.end; i++) {
+                total_weight += colors[i].weight;
+                sum_r += colors[i].weight * colors[i].color.r;
+                sum_g += colors[i].weight * colors[i].color.g;
+                sum_b += colors[i].weight * colors[i].color.b;
+                if (colors[i].weight > colors[most_used].weight)
+                    most_used = i;
+            }
+            ogt_vox_rgba color;
+            color.r = (uint8_t)((sum_r + total_weight / 2) / total_weight);
+            color.g = (uint8_t)((sum_g + total_weight / 2) / total_weight);
+            color.b = (uint8_t)((sum_b + total_weight / 2) / total_weight);
+            color.a = colors[most_used].color.a;
+            palette[box_index] = color;
+        }
+        return (uint32_t)boxes.size();
+    }
+
+    struct _vox_color_histogram_task_data {
+        const ogt_vox_scene** scenes;
+        uint64_t*             histograms;   // 256 voxel counts per scene, one for each color index.
+    };
+
+    // counts how many voxels of each color index are in all models of a scene. Models must already be decoded.
+    static void _vox_color_histogram_task(void* data, uint32_t scene_index) {
+        const _vox_color_histogram_task_data* task_data = (const _vox_color_histogram_task_data*)data;
+        const ogt_vox_scene* scene = task_data->scenes[scene_index];
+        uint64_t* histogram = &task_data->histograms[256 * scene_index];
+        memset(histogram, 0, sizeof(uint64_t) * 256);
+        if (!scene)
+            return;
+        // counting into interleaved sub-histograms stops runs of the same color index from stalling on one counter.
+        uint32_t counts[4][256];
+        for (uint32_t model_index = 0; model_index < scene->num_models; model_index++) {
+            const ogt_vox_model* model = scene->models[model_index];
+            const uint8_t* voxel_data = ogt_vox_get_model_voxels(scene, model_index);
+            const uint32_t voxel_count = model->size_x * model->size_y * model->size_z;
+            memset(counts, 0, sizeof(counts));
+            uint32_t voxel_index = 0;
+            for (; voxel_index + 4 <= voxel_count; voxel_index += 4) {
+                counts[0][voxel_data[voxel_index + 0]]++;
+                counts[1][voxel_data[voxel_index + 1]]++;
+                counts[2][voxel_data[voxel_index + 2]]++;
+                counts[3][voxel_data[voxel_index + 3]]++;
+            }
+            for (; voxel_index < voxel_count; voxel_index++)
+                counts[0][voxel_data[voxel_index]]++;
+            for (uint32_t color_index = 0; color_index < 256; color_index++)
+                histogram[color_index] += (uint64_t)counts[0][color_index] + counts[1][color_index] + counts[2][color_index] + counts[3][color_index];
+        }
+    }
+
+    // builds the master palette from every color used by every scene at once, weighted by how many voxels use each color,
+    // and fills in the 256 entry map from color index to master index for each scene. If all colors fit, they are allocated
+    // in the same order as update_master_palette_from_scene would.
+    static void build_weighted_master_palette(ogt_vox_rgba * master_palette, uint32_t & master_palette_count, _vox_palette_lookup & master_lookup, const ogt_vox_scene** scenes, uint32_t scene_count, uint32_t * scene_to_master_maps) {
+        // grids must be decoded on this thread before the histogram tasks can read them.
+        for (uint32_t scene_index = 0; scene_index < scene_count; scene_index++) {
+            const ogt_vox_scene* scene = scenes[scene_index];
+            for (uint32_t model_index = 0; scene && model_index < scene->num_models; model_index++)
+                ogt_vox_get_model_voxels(scene, model_index);
+        }
+        _vox_array<uint64_t> histograms;
+        histograms.resize(256 * (size_t)scene_count);
+        _vox_color_histogram_task_data task_data;
+        task_data.scenes     = scenes;
+        task_data.histograms = histograms.data;
+        _vox_run_tasks(_vox_color_histogram_task, &task_data, scene_count);
+
+        // gather the distinct colors of all scenes in the order they are first used, leaving out any that are already
+        // in the master palette because they were required.
+        size_t max_colors = 0;
+        for (size_t i = 0; i < histograms.size(); i++)
+            max_colors += ((i & 255) && histograms[i]) ? 1 : 0;
+        _vox_array<_vox_weighted_color> colors;
+        _vox_array<uint32_t> color_table;   // open-addressed table of rgb key -> colors index + 1, 0 if the slot is empty.
+        const uint32_t color_table_mask = _vox_hash_table_mask(max_colors);
+        colors.reserve(max_colors);
+        color_table.resize(color_table_mask + 1);
+        memset(color_table.data, 0, sizeof(uint32_t) * color_table.size());
+        for (uint32_t scene_index = 0; scene_index < scene_count; scene_index++) {
+            const uint64_t* histogram = &histograms[256 * scene_index];
+            for (uint32_t color_index = 1; color_index < 256; color_index++) {
+                if (!histogram[color_index])
+                    continue;
+                const ogt_vox_rgba color = scenes[scene_index]->palette.color[color_index];
+                if (find_exact_color_in_palette(master_lookup, master_palette, color) != UINT32_MAX)
+                    continue;
+                const uint32_t key = _vox_rgb_key(color);
+                uint32_t slot = _vox_rgb_key_hash(key) & color_table_mask;
+                while (color_table[slot] && _vox_rgb_key(colors[color_table[slot] - 1].color) != key)
+                    slot = (slot + 1) & color_table_mask;
+                if (!color_table[slot]) {
+                    _vox_weighted_color new_color;
+                    new_color.color  = color;
+                    new_color.weight = 0;
+                    colors.push_back(new_color);
+                    color_table[slot] = (uint32_t)colors.size();
+                }
+                colors[color_table[slot] - 1].weight += histogram[color_index];
+            }
+        }
+
+        // allocate the colors into the master palette, reducing them first if there are too many.
+        uint32_t num_new_colors = (uint32_t)colors.size();
+        if (master_palette_count + num_new_colors <= 256) {
+            for (uint32_t i = 0; i < num_new_colors; i++)
+                master_palette[master_palette_count + i] = colors[i].color;
+        }
+        else {
+            num_new_colors = _vox_median_cut_colors(colors.data, num_new_colors, &master_palette[master_palette_count], 256 - master_palette_count);
+        }
+        for (uint32_t i = 0; i < num_new_colors; i++) {
+            add_color_to_palette_lookup(master_lookup, master_palette, master_palette_count++);
+        }
+
+        // the master palette is final now, so map each used color in each scene to it.
+        for (uint32_t scene_index = 0; scene_index < scene_count; scene_index++) {
+            if (!scenes[scene_index])
+                continue;
+            const uint64_t* histogram = &histograms[256 * scene_index];
+            uint32_t* scene_to_master_map = &scene_to_master_maps[256 * scene_index];
+            scene_to_master_map[0] = 0;              // zero/empty always maps to zero/empty in the master palette
+            for (uint32_t color_index = 1; color_index < 256; color_index++) {
+                scene_to_master_map[color_index] = UINT32_MAX; // UINT32_MAX means unassigned
+                if (!histogram[color_index])
+                    continue;
+                const ogt_vox_rgba color = scenes[scene_index]->palette.color[color_index];
+                uint32_t master_index = find_exact_color_in_palette(master_lookup, master_palette, color);
+                if (master_index == UINT32_MAX)
+                    master_index = find_closest_color_in_palette(master_lookup, master_palette, master_palette_count, color);
+                scene_to_master_map[color_index] = master_index;
+            }
+        }
+    }
+
     ogt_vox_scene* ogt_vox_merge_scenes(const ogt_vox_scene** scenes, uint32_t scene_count, const ogt_vox_rgba* required_colors, const uint32_t required_color_count) {
+        return ogt_vox_merge_scenes_with_flags(scenes, scene_count, required_colors, required_color_count, 0);
+    }
+
+    ogt_vox_scene* ogt_vox_merge_scenes_with_flags(const ogt_vox_scene** scenes, uint32_t scene_count, const ogt_vox_rgba* required_colors, const uint32_t required_color_count, uint32_t merge_flags) {
         assert(required_color_count <= 255);    // can't exceed the maximum colors in the master palette plus the empty slot.
 
         // initialize the master palette. If required colors are specified, map them into the master palette now.
         ogt_vox_rgba  master_palette[256];
         uint32_t master_palette_count = 1;          // color_index 0 is reserved for empty color!
         memset(&master_palette, 0, sizeof(master_palette));
-        for (uint32_t required_index = 0; required_index < required_color_count; required_index++)
-            master_palette[master_palette_count++] = required_colors[required_index];
+        _vox_palette_lookup master_lookup;          // accelerates color searches in the master palette across all scenes.
+        for (uint32_t required_index = 0; required_index < required_color_count; required_index++) {
+            master_palette[master_palette_count] = required_colors[required_index];
+            add_color_to_palette_lookup(master_lookup, master_palette, master_palette_count++);
+        }
+
+        // with a weighted palette, the master palette and every scene's color map are built up front from all scenes.
+        uint32_t* weighted_color_maps = NULL;
+        if (merge_flags & k_merge_scene_flags_weighted_palette) {
+            weighted_color_maps = (uint32_t*)_vox_malloc(sizeof(uint32_t) * 256 * scene_count);
+            build_weighted_master_palette(master_palette, master_palette_count, master_lookup, scenes, scene_count, weighted_color_maps);
+        }
 
         // count the number of required models, instances in the master scene
         uint32_t max_layers = 1;  // we don't actually merge layers. Every instance will be in layer 0.
@@ -1982,6 +4503,18 @@
         uint32_t num_layers    = 0;
         uint32_t num_groups    = 0;
 
+        // unless duplicates are kept, identical models are found with a hash table of merged model indices that spans all
+        // scenes. scene_model_map maps the model indices of the current scene to merged model indices.
+        const bool remove_duplicate_models = (merge_flags & k_merge_scene_flags_keep_duplicate_models) ? false : true;
+        _vox_array<uint32_t> model_table;
+        _vox_array<uint32_t> scene_model_map;
+        uint32_t model_table_mask = 0;
+        if (remove_duplicate_models) {
+            model_table_mask = _vox_hash_table_mask(max_models);
+            model_table.resize(model_table_mask + 1);
+            memset(model_table.data, -1, sizeof(uint32_t) * model_table.size());
+        }
+
         // add a single layer.
         layers[num_layers].hidden = false;
         layers[num_layers].name = "merged";
@@ -2010,34 +4543,58 @@
                 continue;
 
             // update the master palette, and get the map of this scene's color indices into the master palette. 
-            uint32_t scene_color_index_to_master_map[256];
-            update_master_palette_from_scene(master_palette, master_palette_count, scene, scene_color_index_to_master_map);
+            uint32_t scene_color_index_to_master_map_storage[256];
+            uint32_t* scene_color_index_to_master_map = scene_color_index_to_master_map_storage;
+            if (weighted_color_maps)
+                scene_color_index_to_master_map = &weighted_color_maps[256 * scene_index];
+            else
+                update_master_palette_from_scene(master_palette, master_palette_count, master_lookup, scene, scene_color_index_to_master_map);
+            // color indices that the scene doesn't use are unassigned, and never looked up.
+            uint8_t scene_color_map[256];
+            bool is_identity_map = true;
+            for (uint32_t i = 0; i < 256; i++) {
+                scene_color_map[i] = (scene_color_index_to_master_map[i] < 256) ? (uint8_t)scene_color_index_to_master_map[i] : 0;
+                if (scene_color_index_to_master_map[i] != UINT32_MAX && scene_color_index_to_master_map[i] != i)
+                    is_identity_map = false;
+            }
+            // if no color index changes, models may refer to the source voxels. The merged scene only owns the model itself then.
+            const bool share_voxel_data = is_identity_map && (merge_flags & k_merge_scene_flags_share_voxel_data);
 
-            // cache away the base model index for this scene.
-            uint32_t base_model_index = num_models;
+            // cache away the base group index for this scene.
             uint32_t base_group_index = num_groups;
 
             // create copies of all models that have color indices remapped.
+            scene_model_map.resize(scene->num_models);
             for (uint32_t model_index = 0; model_index < scene->num_models; model_index++) {
                 const ogt_vox_model* model = scene->models[model_index];
+                const uint8_t* voxel_data = ogt_vox_get_model_voxels(scene, model_index);
                 uint32_t voxel_count = model->size_x * model->size_y * model->size_z;
-                // clone the model
-                ogt_vox_model* override_model = (ogt_vox_model*)_vox_malloc(sizeof(ogt_vox_model) + voxel_count);
-                uint8_t * override_voxel_data = (uint8_t*)& override_model[1];
-
-                // remap all color indices in the cloned model so they reference the master palette now!
-                for (uint32_t voxel_index = 0; voxel_index < voxel_count; voxel_index++) {
-                    uint8_t  old_color_index = model->voxel_data[voxel_index];
-                    uint32_t new_color_index = scene_color_index_to_master_map[old_color_index];
-                    assert(new_color_index < 256);
-                    override_voxel_data[voxel_index] = (uint8_t)new_color_index;
+                ogt_vox_model* override_model = NULL;
+                if (share_voxel_data) {
+                    // the source voxels and their hash can be used as they are.
+                    override_model = (ogt_vox_model*)_vox_malloc(sizeof(ogt_vox_model));
+                    *override_model = *model;
+                    override_model->voxel_data = voxel_data;
+                }
+                else {
+                    // clone the model
+                    override_model = (ogt_vox_model*)_vox_malloc(sizeof(ogt_vox_model) + voxel_count);
+                    uint8_t * override_voxel_data = (uint8_t*)& override_model[1];
+
+                    // remap all color indices in the cloned model so they reference the master palette now!
+                    _vox_remap_colors(scene_color_map, voxel_data, override_voxel_data, voxel_count);
+                    // assign the new model.
+                    *override_model = *model;
+                    override_model->voxel_data = override_voxel_data;
+                    override_model->voxel_hash = _vox_hash(override_voxel_data, voxel_count);
                 }
-                // assign the new model.
-                *override_model = *model;
-                override_model->voxel_data = override_voxel_data;
-                override_model->voxel_hash = _vox_hash(override_voxel_data, voxel_count);
 
-                models[num_models++] = override_model;
+                models[num_models] = override_model;
+                scene_model_map[model_index] = remove_duplicate_models ? _vox_find_or_add_model_in_table(model_table.data, model_table_mask, models, num_models) : num_models;
+                if (scene_model_map[model_index] == num_models)
+                    num_models++;
+                else
+                    _vox_free(override_model);  // an identical model was already merged, so share that one instead.
             }
 
             // compute the scene bounding box on x dimension. this is used to offset instances 
@@ -2071,7 +4628,7 @@
                 *dst_instance = *src_instance;
                 dst_instance->layer_index = 0;
                 dst_instance->group_index = (dst_instance->group_index == 0) ? global_root_group_index : base_group_index + (dst_instance->group_index - 1);
-                dst_instance->model_index += base_model_index;
+                dst_instance->model_index = scene_model_map[dst_instance->model_index];
                 if (dst_instance->name)
                     string_data_size += _vox_strlen(dst_instance->name) + 1; // + 1 for zero terminator
                 // if this instance belongs to the global rot group, it must be translated so it doesn't overlap with other scenes.
@@ -2082,6 +4639,7 @@
             offset_x += (scene_max_x - scene_min_x); // step the width of the scene in x dimension
             offset_x += 4;                           // a margin of this many voxels between scenes
         }
+        _vox_free(weighted_color_maps);
 
         // fill any unused master palette entries with purple/invalid color.
         const ogt_vox_rgba k_invalid_color = { 255, 0, 255, 255 };  // purple = invalid
@@ -2089,11 +4647,11 @@
             master_palette[color_index] = k_invalid_color;
 
         // assign the master scene on output. string_data is part of the scene allocation.
-        size_t scene_size = sizeof(ogt_vox_scene) + string_data_size;
+        size_t scene_size = sizeof(ogt_vox_scene) + sizeof(_vox_scene_internal) + string_data_size;
         ogt_vox_scene * merged_scene = (ogt_vox_scene*)_vox_calloc(scene_size);
 
         // copy name data into the string section and make instances point to it. This makes the merged model self-contained.
-        char* scene_string_data = (char*)&merged_scene[1];
+        char* scene_string_data = (char*)&_vox_get_scene_internal(merged_scene)[1];
         for (uint32_t instance_index = 0; instance_index < num_instances; instance_index++) {
             if (instances[instance_index].name) {
                 size_t string_len = _vox_strlen(instances[instance_index].name) + 1; // +1 for zero terminator
@@ -2109,7 +4667,7 @@
         merged_scene->instances     = instances;
         merged_scene->num_instances = max_instances;
         merged_scene->models        = (const ogt_vox_model * *)models;
-        merged_scene->num_models    = max_models;
+        merged_scene->num_models    = num_models;
         merged_scene->layers        = layers;
         merged_scene->num_layers    = max_layers;
         merged_scene->groups        = groups;
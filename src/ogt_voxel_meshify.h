@@ -66,8 +66,20 @@
         We support the following algorithms for meshing the voxel data for now:
 
         * ogt_mesh_from_paletted_voxels_simple:  creates 2 triangles for every visible voxel face.
+        * ogt_mesh_from_packed_voxels_simple:    same as the above, but for sparse voxel data that only lists solid voxels.
         * ogt_mesh_from_paletted_voxels_greedy:  creates 2 triangles for every rectangular region of voxel faces with the same color
+        * ogt_mesh_from_paletted_voxels_greedy_binary: same as the above, but finds the regions with bitmasks of solid voxels, which is much faster.
         * ogt_mesh_from_paletted_voxels_polygon: determines the polygon contour of every connected voxel face with the same color and then triangulates that.
+
+        The greedy and polygon meshers also have *_parallel variants that mesh ranges of slices of each face direction as independent
+        tasks on a job system you provide, and produce exactly the same mesh as their serial versions. If you set the job functions of
+        ogt_voxel_meshify_context, the simple, greedy and polygon meshers all spread their work across your job system this way.
+
+        Many models can be meshed at once with ogt_mesh_from_paletted_voxel_models, or ogt_mesh_from_scene_models if ogt_vox.h is
+        included before this file. These balance the models across the job system by how many faces they have.
+
+        ogt_mesh_compact_from_paletted_voxels meshes with any of the simple, greedy or polygon algorithms into compact vertices that
+        have integer positions, a face id instead of a normal, and a palette index and/or color, which are 3 to 5 times smaller.
 */
 #ifndef OGT_VOXEL_MESHIFY_H__
 #define OGT_VOXEL_MESHIFY_H__
@@ -79,6 +91,7 @@
     typedef signed int    int32_t;
     typedef unsigned int  uint32_t;
     typedef unsigned short uint16_t;
+    typedef unsigned __int64 uint64_t;
     #ifndef UINT32_MAX
         #define UINT32_MAX	0xFFFFFFFF
     #endif
@@ -116,6 +129,13 @@ struct ogt_mesh_vertex
     ogt_mesh_rgba  color;
 };
 
+// a solid voxel within a sparse voxel field. This has the same layout as ogt_vox_packed_voxel.
+struct ogt_mesh_packed_voxel
+{
+    uint8_t x, y, z;
+    uint8_t color_index;
+};
+
 // a mesh that contains an indexed triangle list of vertices
 struct ogt_mesh 
 {
@@ -134,12 +154,27 @@ typedef void  (*ogt_voxel_meshify_free_func)(void* ptr, void* user_data);
 // stream function can receive a batch of triangles for each voxel processed by ogt_stream_from_paletted_voxels_simple. (i,j,k) 
 typedef void (*ogt_voxel_simple_stream_func)(uint32_t x, uint32_t y, uint32_t z, const ogt_mesh_vertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, void* user_data);
 
+// a unit of work that the meshers want to run. task_data is opaque to the job system and task_index identifies the task.
+typedef void (*ogt_voxel_meshify_task_func)(void* task_data, uint32_t task_index);
+
+// job submit function interface. run task_func(task_data, task_index) on any thread, possibly immediately on the calling thread.
+typedef void (*ogt_voxel_meshify_job_submit_func)(ogt_voxel_meshify_task_func task_func, void* task_data, uint32_t task_index, void* user_data);
+
+// job wait function interface. blocks until all tasks submitted via the submit function have finished.
+typedef void (*ogt_voxel_meshify_job_wait_func)(void* user_data);
+
 // a context that allows you to override various internal operations of the below api functions.
+// If job_submit_func and job_wait_func are set, the meshers spread their work across that job system and produce the same meshes as when they
+// are NULL, in which case all work runs serially on the calling thread. Tasks call alloc_func and free_func, so those must then be thread-safe.
+// Tasks never submit tasks of their own, and a mesher only waits on the calling thread.
 struct ogt_voxel_meshify_context
 {
     ogt_voxel_meshify_alloc_func                alloc_func;                 // override allocation function
     ogt_voxel_meshify_free_func                 free_func;                  // override free function
     void*                                       alloc_free_user_data;       // alloc/free user-data (passed to alloc_func / free_func )
+    ogt_voxel_meshify_job_submit_func           job_submit_func;            // job system to run tasks on (NULL = run serially)
+    ogt_voxel_meshify_job_wait_func             job_wait_func;              // waits for the tasks submitted via job_submit_func
+    void*                                       job_user_data;              // job system user-data (passed to job_submit_func / job_wait_func)
 };
 
 // returns the number of quad faces that would be generated by tessellating the specified voxel field using the simple algorithm. Useful for preallocating memory.
@@ -149,15 +184,126 @@ uint32_t ogt_face_count_from_paletted_voxels_simple(const uint8_t* voxels, uint3
 // The simple meshifier returns the most naieve mesh possible, which will be tessellated at voxel granularity. 
 ogt_mesh* ogt_mesh_from_paletted_voxels_simple(const ogt_voxel_meshify_context* ctx, const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette);
 
+// Same as the simple meshifier, but consumes a sparse voxel field instead of a grid. voxels must only contain solid voxels sorted 
+// in z -> y -> x order, and the voxels in row (y,z) are voxels[row_offsets[y + z * size_y]] up to but excluding 
+// voxels[row_offsets[y + z * size_y + 1]]. This is the layout of ogt_vox_sparse_model. Produces the same mesh as the grid version.
+ogt_mesh* ogt_mesh_from_packed_voxels_simple(const ogt_voxel_meshify_context* ctx, const ogt_mesh_packed_voxel* voxels, const uint32_t* row_offsets, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette);
+
+// returns the number of quad faces that ogt_mesh_from_packed_voxels_simple would generate for the specified sparse voxel field.
+uint32_t ogt_face_count_from_packed_voxels_simple(const ogt_mesh_packed_voxel* voxels, const uint32_t* row_offsets, uint32_t size_x, uint32_t size_y, uint32_t size_z);
+
 // The greedy meshifier will use a greedy box-expansion pass to replace the polygons of adjacent voxels of the same color with a larger polygon that covers the box.
 // It will generally produce t-junctions which can make rasterization not water-tight based on your camera/project/distances.
 ogt_mesh* ogt_mesh_from_paletted_voxels_greedy(const ogt_voxel_meshify_context* ctx, const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette);
 
+// Produces exactly the same mesh as ogt_mesh_from_paletted_voxels_greedy, but finds visible faces and grows rectangles using 64-bit masks
+// of solid voxels per row rather than one voxel at a time. Slices are not limited to 65536 voxels. Needs scratch memory the size of the grid.
+ogt_mesh* ogt_mesh_from_paletted_voxels_greedy_binary(const ogt_voxel_meshify_context* ctx, const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette);
+
 // The polygon meshifier will polygonize and triangulate connected voxels that are of the same color. The boundary of the polygon
 // will be tessellated only to the degree that is necessary to there are tessellations at color discontinuities.
 // This will mostly be water-tight, except for a very small number of cases.
 ogt_mesh* ogt_mesh_from_paletted_voxels_polygon(const ogt_voxel_meshify_context* ctx, const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette);
 
+// Parallel variants of the greedy and polygon meshifiers. Ranges of slices of each face direction are meshed as tasks submitted via submit_func
+// into their own buffers, which are then concatenated in order, so the mesh is exactly the same as the serial version's. If submit_func and
+// wait_func are NULL, the context's job system is used, or the tasks run serially on the calling thread if it has none. The context's alloc_func
+// and free_func are called from tasks, so they must be thread-safe. The greedy variant finds quads like ogt_mesh_from_paletted_voxels_greedy_binary, and needs scratch memory twice the size of the grid.
+ogt_mesh* ogt_mesh_from_paletted_voxels_greedy_parallel(const ogt_voxel_meshify_context* ctx, const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette,
+    ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* job_user_data);
+ogt_mesh* ogt_mesh_from_paletted_voxels_polygon_parallel(const ogt_voxel_meshify_context* ctx, const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette,
+    ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* job_user_data);
+
+// the meshing algorithms that the batch meshers can use.
+enum ogt_mesh_algorithm
+{
+    ogt_mesh_algorithm_simple  = 0,  // ogt_mesh_from_paletted_voxels_simple
+    ogt_mesh_algorithm_greedy  = 1,  // ogt_mesh_from_paletted_voxels_greedy, using the binary greedy search which gives the same mesh
+    ogt_mesh_algorithm_polygon = 2   // ogt_mesh_from_paletted_voxels_polygon
+};
+
+// a grid of paletted voxels for ogt_mesh_from_paletted_voxel_models.
+struct ogt_mesh_voxel_model
+{
+    const uint8_t* voxels;
+    uint32_t       size_x, size_y, size_z;
+};
+
+// Meshes every model with the specified algorithm and palette, writing the mesh of models[i] to out_meshes[i]. Returns true if every mesh was
+// made, otherwise the meshes that could not be made are NULL. Models are counted and meshed as tasks submitted via submit_func: small models
+// are batched into tasks by their number of faces, and models with very many faces are meshed with the *_parallel variants so that they don't
+// hold up the others. Each mesh is the same as meshing that model on its own, and must be destroyed with ogt_mesh_destroy. If submit_func and
+// wait_func are NULL, the context's job system is used, or everything runs serially on the calling thread if it has none. The context's alloc_func
+// and free_func must be thread-safe.
+bool ogt_mesh_from_paletted_voxel_models(const ogt_voxel_meshify_context* ctx, const ogt_mesh_voxel_model* models, uint32_t model_count, const ogt_mesh_rgba* palette,
+    ogt_mesh_algorithm algorithm, ogt_mesh** out_meshes, ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* job_user_data);
+
+// the layouts of the vertices of an ogt_mesh_compact. Positions are integer voxel coordinates. face identifies the normal, which is
+// 0 = +x, 1 = -x, 2 = +y, 3 = -y, 4 = +z, 5 = -z. color_index is the palette index of the voxels the vertex belongs to.
+enum ogt_mesh_compact_format
+{
+    ogt_mesh_compact_format_u8_index  = 0,  // ogt_mesh_compact_vertex_u8_index, 5 bytes. Needs a grid of at most 255 voxels along each axis.
+    ogt_mesh_compact_format_u8_rgba   = 1,  // ogt_mesh_compact_vertex_u8_rgba, 8 bytes. Needs a grid of at most 255 voxels along each axis.
+    ogt_mesh_compact_format_u16_index = 2,  // ogt_mesh_compact_vertex_u16_index, 8 bytes.
+    ogt_mesh_compact_format_u16_rgba  = 3   // ogt_mesh_compact_vertex_u16_rgba, 12 bytes.
+};
+
+struct ogt_mesh_compact_vertex_u8_index
+{
+    uint8_t x, y, z;
+    uint8_t face;
+    uint8_t color_index;
+};
+
+struct ogt_mesh_compact_vertex_u8_rgba
+{
+    uint8_t       x, y, z;
+    uint8_t       face;
+    ogt_mesh_rgba color;
+};
+
+struct ogt_mesh_compact_vertex_u16_index
+{
+    uint16_t x, y, z;
+    uint8_t  face;
+    uint8_t  color_index;
+};
+
+struct ogt_mesh_compact_vertex_u16_rgba
+{
+    uint16_t      x, y, z;
+    uint8_t       face;
+    uint8_t       color_index;
+    ogt_mesh_rgba color;
+};
+
+// a mesh that contains an indexed triangle list of compact vertices.
+struct ogt_mesh_compact
+{
+    uint32_t                vertex_count;   // number of vertices
+    uint32_t                index_count;    // number of indices
+    ogt_mesh_compact_format format;         // layout of the vertices
+    uint32_t                vertex_size;    // size of each vertex in bytes
+    void*                   vertices;       // array of vertices, of the struct that format specifies
+    uint32_t*               indices;        // array of indices
+};
+
+// Meshes the voxel grid with the specified algorithm, and returns the mesh with its vertices in the specified compact format. The mesh has
+// the same triangles, in the same order, as ogt_mesh_from_paletted_voxels_* would produce. palette is only used by the rgba formats. Returns NULL
+// if the grid is too large for the format. Uses the context's job system if it has one. Destroy the mesh with ogt_mesh_compact_destroy.
+ogt_mesh_compact* ogt_mesh_compact_from_paletted_voxels(const ogt_voxel_meshify_context* ctx, const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z,
+    const ogt_mesh_rgba* palette, ogt_mesh_algorithm algorithm, ogt_mesh_compact_format format);
+
+// destroys the mesh returned by ogt_mesh_compact_from_paletted_voxels.
+void ogt_mesh_compact_destroy(const ogt_voxel_meshify_context* ctx, ogt_mesh_compact* mesh);
+
+#if defined(OGT_VOX_H__)
+// Same as ogt_mesh_from_paletted_voxel_models for every model of the scene with the scene palette. out_meshes needs room for scene->num_models
+// meshes. Models read with k_read_scene_flags_lazy_models are decoded by the tasks, so no other thread may access them at the same time.
+bool ogt_mesh_from_scene_models(const ogt_voxel_meshify_context* ctx, const ogt_vox_scene* scene, ogt_mesh_algorithm algorithm, ogt_mesh** out_meshes,
+    ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* job_user_data);
+#endif
+
 // ogt_mesh_remove_duplicate_vertices will in-place remove identical vertices and remap indices to produce an identical mesh.
 // Use this after a call to ogt_mesh_from_paletted_voxels_* functions to remove duplicate vertices with the same attributes.
 void	  ogt_mesh_remove_duplicate_vertices(const ogt_voxel_meshify_context* ctx, ogt_mesh* mesh);
@@ -172,6 +318,9 @@ void      ogt_mesh_destroy(const ogt_voxel_meshify_context* ctx, ogt_mesh* mesh
 // The simple stream function will stream geometry for the specified voxel field, to the specified stream function, which will be invoked on each voxel that requires geometry. 
 void     ogt_stream_from_paletted_voxels_simple(const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette, ogt_voxel_simple_stream_func stream_func, void* stream_func_data);
 
+// Same as ogt_stream_from_paletted_voxels_simple, but consumes a sparse voxel field. See ogt_mesh_from_packed_voxels_simple.
+void     ogt_stream_from_packed_voxels_simple(const ogt_mesh_packed_voxel* voxels, const uint32_t* row_offsets, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette, ogt_voxel_simple_stream_func stream_func, void* stream_func_data);
+
 
 #endif // OGT_VOXEL_MESHIFY_H__
 
@@ -186,6 +335,16 @@ void     ogt_stream_from_paletted_voxels_simple(const uint8_t* voxels, uint32_t
 #include <stdlib.h>
 #include <memory.h>
 #include <math.h>
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+// SIMD headers for the binary greedy mesher. Define OGT_VOXEL_MESHIFY_NO_SIMD before the implementation to only use scalar code.
+#if !defined(OGT_VOXEL_MESHIFY_NO_SIMD)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #include <emmintrin.h>
+        #define _MESH_HAVE_SSE2 1
+    #endif
+#endif
 
 // a set of up to 65536 bits
 struct ogt_mesh_bitset_64k {
@@ -220,6 +379,50 @@ static void _voxel_meshify_free(const ogt_voxel_meshify_context* ctx, void* old_
     }
 }
 
+// the job system that the meshers submit their tasks to. A NULL submit_func means tasks are run serially.
+struct _mesh_job_system {
+    ogt_voxel_meshify_job_submit_func submit_func;
+    ogt_voxel_meshify_job_wait_func   wait_func;
+    void*                             user_data;
+};
+
+// uses the specified job functions if they are non-NULL, otherwise those of the context.
+static _mesh_job_system _make_job_system(const ogt_voxel_meshify_context* ctx, ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* user_data) {
+    if (!submit_func && !wait_func) {
+        submit_func = ctx->job_submit_func;
+        wait_func   = ctx->job_wait_func;
+        user_data   = ctx->job_user_data;
+    }
+    assert((submit_func && wait_func) ||      // both submit/wait must be non-NULL -OR-
+        (!submit_func && !wait_func));        // both submit/wait must be NULL. No mixing 'n matching.
+    _mesh_job_system jobs;
+    jobs.submit_func = (submit_func && wait_func) ? submit_func : NULL;
+    jobs.wait_func   = (submit_func && wait_func) ? wait_func : NULL;
+    jobs.user_data   = user_data;
+    return jobs;
+}
+
+// returns how many slices of slice_size voxels make a range of slices that is worth a task. This is a multiple of 8 slices unless the
+// slices are very large.
+static uint32_t _mesh_slices_per_range(uint32_t slice_size) {
+    const uint32_t k_voxels_per_range = 256 * 1024;
+    uint32_t slices_per_range = slice_size ? k_voxels_per_range / slice_size : 0;
+    return slices_per_range >= 8 ? (slices_per_range & ~7u) : (slices_per_range ? slices_per_range : 1);
+}
+
+// runs task_func for every task index in [0, task_count) and returns once they have all finished.
+static void _mesh_run_tasks(const _mesh_job_system& jobs, ogt_voxel_meshify_task_func task_func, void* task_data, uint32_t task_count) {
+    if (jobs.submit_func && task_count > 1) {
+        for (uint32_t i = 0; i < task_count; i++)
+            jobs.submit_func(task_func, task_data, i, jobs.user_data);
+        jobs.wait_func(jobs.user_data);
+    }
+    else {
+        for (uint32_t i = 0; i < task_count; i++)
+            task_func(task_data, i);
+    }
+}
+
 // column-major 4x4 matrix
 struct ogt_mesh_transform  {
     float m00, m01, m02, m03;   // column 0 of 4x4 matrix, 1st three elements = x axis vector, last element always 0.0
@@ -319,8 +522,182 @@ static inline ogt_mesh_vertex _mesh_make_vertex(float pos_x, float pos_y, float
     return _mesh_make_vertex(_make_vec3(pos_x, pos_y, pos_z), _make_vec3(normal_x, normal_y, normal_z), color);
 }
 
+// the normal of each face id, in the order of the compact vertex formats: +x, -x, +y, -y, +z, -z.
+static const float k_mesh_face_normals[6][3] = {
+    { 1.0f, 0.0f, 0.0f }, {-1.0f, 0.0f, 0.0f },
+    { 0.0f, 1.0f, 0.0f }, { 0.0f,-1.0f, 0.0f },
+    { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f,-1.0f }
+};
+
+// returns the face id of an axis aligned normal.
+static uint32_t _mesh_face_from_normal(const ogt_mesh_vec3& normal) {
+    if (normal.x != 0.0f)
+        return normal.x > 0.0f ? 0 : 1;
+    if (normal.y != 0.0f)
+        return normal.y > 0.0f ? 2 : 3;
+    return normal.z > 0.0f ? 4 : 5;
+}
+
+// writes count vertices of a vertex array from first_vertex on, which share the face id of their normal and their palette index.
+typedef void (*_mesh_write_vertices_func)(void* vertices, uint32_t first_vertex, const ogt_mesh_vec3* positions, uint32_t count, uint32_t face, uint8_t color_index, const ogt_mesh_rgba* palette);
+
+static void _mesh_write_vertices(void* vertices, uint32_t first_vertex, const ogt_mesh_vec3* positions, uint32_t count, uint32_t face, uint8_t color_index, const ogt_mesh_rgba* palette) {
+    const ogt_mesh_vec3 normal = _make_vec3(k_mesh_face_normals[face][0], k_mesh_face_normals[face][1], k_mesh_face_normals[face][2]);
+    const ogt_mesh_rgba color  = palette[color_index];
+    ogt_mesh_vertex* out = &((ogt_mesh_vertex*)vertices)[first_vertex];
+    for (uint32_t i = 0; i < count; i++)
+        out[i] = _mesh_make_vertex(positions[i], normal, color);
+}
+
+static inline void _mesh_compact_write_color(ogt_mesh_compact_vertex_u8_index& out, uint8_t color_index, const ogt_mesh_rgba* palette) {
+    (void)palette;
+    out.color_index = color_index;
+}
+static inline void _mesh_compact_write_color(ogt_mesh_compact_vertex_u8_rgba& out, uint8_t color_index, const ogt_mesh_rgba* palette) {
+    out.color = palette[color_index];
+}
+static inline void _mesh_compact_write_color(ogt_mesh_compact_vertex_u16_index& out, uint8_t color_index, const ogt_mesh_rgba* palette) {
+    (void)palette;
+    out.color_index = color_index;
+}
+static inline void _mesh_compact_write_color(ogt_mesh_compact_vertex_u16_rgba& out, uint8_t color_index, const ogt_mesh_rgba* palette) {
+    out.color_index = color_index;
+    out.color       = palette[color_index];
+}
+
+// writes compact vertices of type VERTEX, whose position components are of type COMPONENT.
+template <class VERTEX, class COMPONENT>
+static void _mesh_compact_write_vertices(void* vertices, uint32_t first_vertex, const ogt_mesh_vec3* positions, uint32_t count, uint32_t face, uint8_t color_index, const ogt_mesh_rgba* palette) {
+    VERTEX* out = &((VERTEX*)vertices)[first_vertex];
+    for (uint32_t i = 0; i < count; i++) {
+        out[i].x    = (COMPONENT)positions[i].x;
+        out[i].y    = (COMPONENT)positions[i].y;
+        out[i].z    = (COMPONENT)positions[i].z;
+        out[i].face = (uint8_t)face;
+        _mesh_compact_write_color(out[i], color_index, palette);
+    }
+}
+
+// the output of a mesher. Meshers write every vertex through write_vertices, so they make ogt_mesh_vertex and each of the compact vertex
+// formats directly. Vertices and indices are appended at vertex_count and index_count.
+struct _mesh_writer {
+    _mesh_write_vertices_func write_vertices;
+    bool                    is_compact;     // whether the mesh is an ogt_mesh_compact rather than an ogt_mesh
+    ogt_mesh_compact_format compact_format; // the format of the vertices if is_compact
+    uint32_t                vertex_size;    // size of each vertex in bytes
+    const ogt_mesh_rgba*    palette;
+    void*                   vertices;
+    uint32_t*               indices;
+    uint32_t                vertex_count;
+    uint32_t                index_count;
+};
+
+// returns a writer of ogt_mesh_vertex colored from the palette.
+static _mesh_writer _make_mesh_writer(const ogt_mesh_rgba* palette) {
+    _mesh_writer out;
+    out.write_vertices = _mesh_write_vertices;
+    out.is_compact     = false;
+    out.compact_format = ogt_mesh_compact_format_u16_index;
+    out.vertex_size    = sizeof(ogt_mesh_vertex);
+    out.palette        = palette;
+    out.vertices       = NULL;
+    out.indices        = NULL;
+    out.vertex_count   = 0;
+    out.index_count    = 0;
+    return out;
+}
+
+// returns a writer of the specified compact vertex format. palette is only used by the rgba formats.
+static _mesh_writer _make_mesh_compact_writer(ogt_mesh_compact_format format, const ogt_mesh_rgba* palette) {
+    _mesh_writer out = _make_mesh_writer(palette);
+    out.is_compact     = true;
+    out.compact_format = format;
+    switch (format) {
+        case ogt_mesh_compact_format_u8_index:
+            out.write_vertices = _mesh_compact_write_vertices<ogt_mesh_compact_vertex_u8_index, uint8_t>;
+            out.vertex_size    = sizeof(ogt_mesh_compact_vertex_u8_index);
+            break;
+        case ogt_mesh_compact_format_u8_rgba:
+            out.write_vertices = _mesh_compact_write_vertices<ogt_mesh_compact_vertex_u8_rgba, uint8_t>;
+            out.vertex_size    = sizeof(ogt_mesh_compact_vertex_u8_rgba);
+            break;
+        case ogt_mesh_compact_format_u16_index:
+            out.write_vertices = _mesh_compact_write_vertices<ogt_mesh_compact_vertex_u16_index, uint16_t>;
+            out.vertex_size    = sizeof(ogt_mesh_compact_vertex_u16_index);
+            break;
+        case ogt_mesh_compact_format_u16_rgba:
+            out.write_vertices = _mesh_compact_write_vertices<ogt_mesh_compact_vertex_u16_rgba, uint16_t>;
+            out.vertex_size    = sizeof(ogt_mesh_compact_vertex_u16_rgba);
+            break;
+    }
+    return out;
+}
+
+// allocates an ogt_mesh, or an ogt_mesh_compact for a compact writer, with room for the specified number of vertices and indices, and points
+// the writer at its empty arrays. Returns NULL if it is out of memory.
+static void* _mesh_writer_alloc(const ogt_voxel_meshify_context* ctx, _mesh_writer& out, uint32_t max_vertex_count, uint32_t max_index_count) {
+    out.vertex_count = 0;
+    out.index_count  = 0;
+    if (out.is_compact) {
+        // indices are placed first so that they stay aligned whatever the vertex size.
+        size_t mesh_size = sizeof(ogt_mesh_compact) + (max_index_count * sizeof(uint32_t)) + ((size_t)max_vertex_count * out.vertex_size);
+        ogt_mesh_compact* mesh = (ogt_mesh_compact*)_voxel_meshify_malloc(ctx, mesh_size);
+        if (!mesh)
+            return NULL;
+        mesh->format      = out.compact_format;
+        mesh->vertex_size = out.vertex_size;
+        mesh->indices     = (uint32_t*)&mesh[1];
+        mesh->vertices    = &mesh->indices[max_index_count];
+        out.vertices = mesh->vertices;
+        out.indices  = mesh->indices;
+        return mesh;
+    }
+    uint32_t mesh_size = sizeof(ogt_mesh) + (max_vertex_count * sizeof(ogt_mesh_vertex)) + (max_index_count * sizeof(uint32_t));
+    ogt_mesh* mesh = (ogt_mesh*)_voxel_meshify_malloc(ctx, mesh_size);
+    if (!mesh)
+        return NULL;
+    mesh->vertices = (ogt_mesh_vertex*)&mesh[1];
+    mesh->indices  = (uint32_t*)&mesh->vertices[max_vertex_count];
+    out.vertices = mesh->vertices;
+    out.indices  = mesh->indices;
+    return mesh;
+}
+
+// records the number of vertices and indices that the writer wrote in the mesh that _mesh_writer_alloc allocated, and returns the mesh.
+static void* _mesh_writer_finish(void* mesh, const _mesh_writer& out) {
+    if (out.is_compact) {
+        ((ogt_mesh_compact*)mesh)->vertex_count = out.vertex_count;
+        ((ogt_mesh_compact*)mesh)->index_count  = out.index_count;
+    }
+    else {
+        ((ogt_mesh*)mesh)->vertex_count = out.vertex_count;
+        ((ogt_mesh*)mesh)->index_count  = out.index_count;
+    }
+    return mesh;
+}
+
+// the orders that the 2 triangles of a quad index its corners in. The reversed and flipped orders have the opposite winding.
+static const uint8_t k_mesh_quad_corners[6]          = { 0, 1, 2, 2, 3, 0 };
+static const uint8_t k_mesh_quad_corners_reversed[6] = { 2, 1, 0, 0, 3, 2 };
+static const uint8_t k_mesh_quad_corners_flipped[6]  = { 0, 3, 2, 2, 1, 0 };
+
+// writes the 4 corners of a quad with the specified face id and palette index, and the 6 indices of its 2 triangles, which index the
+// corners in corner_order.
+static void _mesh_write_quad(_mesh_writer& out, const ogt_mesh_vec3& v0, const ogt_mesh_vec3& v1, const ogt_mesh_vec3& v2, const ogt_mesh_vec3& v3,
+    uint32_t face, uint8_t color_index, const uint8_t* corner_order)
+{
+    const ogt_mesh_vec3 corners[4] = { v0, v1, v2, v3 };
+    out.write_vertices(out.vertices, out.vertex_count, corners, 4, face, color_index, out.palette);
+    uint32_t* index_data = &out.indices[out.index_count];
+    for (uint32_t i = 0; i < 6; i++)
+        index_data[i] = out.vertex_count + corner_order[i];
+    out.vertex_count += 4;
+    out.index_count  += 6;
+}
+
 // counts the number of voxel sized faces that are needed for this voxel grid.
-static uint32_t _count_voxel_sized_faces( const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z ) {
+// counts the faces of the voxels in the z slices from k_begin up to but excluding k_end.
+static uint32_t _count_voxel_sized_faces_in_z_slices( const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, uint32_t k_begin, uint32_t k_end ) {
     const int32_t k_stride_x = 1;
     const int32_t k_stride_y = size_x;
     const int32_t k_stride_z = size_x * size_y;
@@ -330,8 +707,8 @@ static uint32_t _count_voxel_sized_faces( const uint8_t* voxels, uint32_t size_x
 
     uint32_t face_count  = 0;
         
-    const uint8_t* current_voxel = voxels;
-    for (uint32_t k = 0; k < size_z; k++)
+    const uint8_t* current_voxel = voxels + (size_t)k_begin * k_stride_z;
+    for (uint32_t k = k_begin; k < k_end; k++)
     {
         for (uint32_t j = 0; j < size_y; j++)
         {
@@ -353,6 +730,10 @@ static uint32_t _count_voxel_sized_faces( const uint8_t* voxels, uint32_t size_x
     return face_count;
 }
 
+static uint32_t _count_voxel_sized_faces( const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z ) {
+    return _count_voxel_sized_faces_in_z_slices(voxels, size_x, size_y, size_z, 0, size_z);
+}
+
 
 // murmur_hash2 - this variant deals with only 4 bytes at a time
 static uint32_t murmur_hash2_size4(uint32_t h, const uint32_t* data, uint32_t data_len) {
@@ -541,86 +922,104 @@ void ogt_mesh_smooth_normals(const ogt_voxel_meshify_context* ctx, ogt_mesh* mes
     _voxel_meshify_free(ctx, remap_indices);
 }
 
-static void _streaming_add_to_mesh(uint32_t x, uint32_t y, uint32_t z, const ogt_mesh_vertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, void* stream_func_data) {
-    // these params are unused for now.
-    (void)x; (void)y; (void)z;
-    // copy the specified vertices and indices into the mesh
-    ogt_mesh* mesh = (ogt_mesh*)stream_func_data;
-    memcpy(&mesh->vertices[mesh->vertex_count], vertices, vertex_count * sizeof(ogt_mesh_vertex));
-    memcpy(&mesh->indices[mesh->index_count], indices, index_count * sizeof(uint32_t));
-    mesh->vertex_count += vertex_count;
-    mesh->index_count += index_count;
+// writes the geometry for the faces of a single voxel, where the neg_*/pos_* parameters determine which faces are needed.
+static void _stream_voxel_faces_simple(
+    _mesh_writer& out, uint32_t i, uint32_t j, uint32_t k, uint8_t color_index,
+    uint32_t neg_x, uint32_t pos_x, uint32_t neg_y, uint32_t pos_y, uint32_t neg_z, uint32_t pos_z)
+{
+    // determine the min/max coords of the voxel for each dimension.
+    const float min_x = (float)i;
+    const float max_x = min_x + 1.0f;
+    const float min_y = (float)j;
+    const float max_y = min_y + 1.0f;
+    const float min_z = (float)k;
+    const float max_z = min_z + 1.0f;
+
+    // -X direction face
+    if (neg_x)
+        _mesh_write_quad(out, _make_vec3(min_x, min_y, min_z), _make_vec3(min_x, max_y, min_z), _make_vec3(min_x, max_y, max_z), _make_vec3(min_x, min_y, max_z), 1, color_index, k_mesh_quad_corners_reversed);
+    // +X direction face
+    if (pos_x)
+        _mesh_write_quad(out, _make_vec3(max_x, min_y, min_z), _make_vec3(max_x, max_y, min_z), _make_vec3(max_x, max_y, max_z), _make_vec3(max_x, min_y, max_z), 0, color_index, k_mesh_quad_corners);
+    // -Y direction face
+    if (neg_y)
+        _mesh_write_quad(out, _make_vec3(min_x, min_y, min_z), _make_vec3(max_x, min_y, min_z), _make_vec3(max_x, min_y, max_z), _make_vec3(min_x, min_y, max_z), 3, color_index, k_mesh_quad_corners);
+    // +Y direction face
+    if (pos_y)
+        _mesh_write_quad(out, _make_vec3(min_x, max_y, min_z), _make_vec3(max_x, max_y, min_z), _make_vec3(max_x, max_y, max_z), _make_vec3(min_x, max_y, max_z), 2, color_index, k_mesh_quad_corners_reversed);
+    // -Z direction face
+    if (neg_z)
+        _mesh_write_quad(out, _make_vec3(min_x, min_y, min_z), _make_vec3(max_x, min_y, min_z), _make_vec3(max_x, max_y, min_z), _make_vec3(min_x, max_y, min_z), 5, color_index, k_mesh_quad_corners_reversed);
+    // +Z direction face
+    if (pos_z)
+        _mesh_write_quad(out, _make_vec3(min_x, min_y, max_z), _make_vec3(max_x, min_y, max_z), _make_vec3(max_x, max_y, max_z), _make_vec3(min_x, max_y, max_z), 4, color_index, k_mesh_quad_corners);
 }
 
+// writes the faces that are needed for each voxel visited by _visit_paletted_voxel_faces or _visit_packed_voxel_faces into a mesh.
+struct _voxel_face_writer {
+    _mesh_writer* out;
+    void operator()(uint32_t i, uint32_t j, uint32_t k, uint8_t color_index, uint32_t neg_x, uint32_t pos_x, uint32_t neg_y, uint32_t pos_y, uint32_t neg_z, uint32_t pos_z) {
+        _stream_voxel_faces_simple(*out, i, j, k, color_index, neg_x, pos_x, neg_y, pos_y, neg_z, pos_z);
+    }
+};
+
+// streams the faces that are needed for each voxel visited by _visit_paletted_voxel_faces or _visit_packed_voxel_faces to a user function.
+struct _voxel_face_streamer {
+    const ogt_mesh_rgba*         palette;
+    ogt_voxel_simple_stream_func stream_func;
+    void*                        stream_func_data;
+    uint32_t                     total_vertex_count;
+    void operator()(uint32_t i, uint32_t j, uint32_t k, uint8_t color_index, uint32_t neg_x, uint32_t pos_x, uint32_t neg_y, uint32_t pos_y, uint32_t neg_z, uint32_t pos_z) {
+        // skip voxels that need no faces.
+        if (!(neg_x + pos_x + neg_y + pos_y + neg_z + pos_z))
+            return;
+
+        // generate geometry for this voxel to a local buffer first.
+        ogt_mesh_vertex local_vertex[24];
+        uint32_t        local_index[36];
+        _mesh_writer local = _make_mesh_writer(palette);
+        local.vertices = local_vertex;
+        local.indices  = local_index;
+        _stream_voxel_faces_simple(local, i, j, k, color_index, neg_x, pos_x, neg_y, pos_y, neg_z, pos_z);
+        for (uint32_t index = 0; index < local.index_count; index++)
+            local_index[index] += total_vertex_count;
+        total_vertex_count += local.vertex_count;
+
+        // geometry for this voxel is provided to a caller-specified stream function/callback
+        stream_func(i, j, k, local_vertex, local.vertex_count, local_index, local.index_count, stream_func_data);
+    }
+};
+
 // returns the number of quad faces that would be generated by tessellating the specified voxel field using the simple algorithm.
 uint32_t ogt_face_count_from_paletted_voxels_simple(const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z)
 {
     return _count_voxel_sized_faces( voxels, size_x, size_y, size_z );
 }
 
-// constructs and returns a mesh from the specified voxel grid with no optimization to the geometry.
-ogt_mesh* ogt_mesh_from_paletted_voxels_simple(
-    const ogt_voxel_meshify_context* ctx,
-    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette) 
+// determines which faces are needed for every solid voxel in the z slices from k_begin up to but excluding k_end, and calls visit_func on each of them.
+template<class VISIT_FUNC>
+static void _visit_paletted_voxel_faces(
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, uint32_t k_begin, uint32_t k_end, VISIT_FUNC& visit_func)
 {
-    uint32_t max_face_count   = _count_voxel_sized_faces( voxels, size_x, size_y, size_z );
-    uint32_t max_vertex_count = max_face_count * 4;
-    uint32_t max_index_count  = max_face_count * 6;
-    
-    uint32_t mesh_size = sizeof(ogt_mesh) + (max_vertex_count * sizeof(ogt_mesh_vertex)) + (max_index_count * sizeof(uint32_t));
-    ogt_mesh* mesh = (ogt_mesh*)_voxel_meshify_malloc(ctx, mesh_size);
-    if (!mesh)
-        return NULL;
-    
-    mesh->vertices = (ogt_mesh_vertex*)&mesh[1];
-    mesh->indices  = (uint32_t*)&mesh->vertices[max_vertex_count];
-    mesh->vertex_count = 0;
-    mesh->index_count  = 0;
-    
-    ogt_stream_from_paletted_voxels_simple(voxels, size_x, size_y, size_z, palette, _streaming_add_to_mesh, mesh);
-    
-    assert( mesh->vertex_count == max_vertex_count);
-    assert( mesh->index_count == max_index_count);	
-    return mesh;
-}
-
-// streams geometry for each voxel at a time to a specified user function.
-void ogt_stream_from_paletted_voxels_simple(
-    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette,
-    ogt_voxel_simple_stream_func stream_func, void* stream_func_data) 
-{
-    assert(stream_func);
     const int32_t k_stride_x = 1;
     const int32_t k_stride_y = size_x;
     const int32_t k_stride_z = size_x * size_y;
-    const int32_t k_max_x = size_x - 1;
-    const int32_t k_max_y = size_y - 1;
-    const int32_t k_max_z = size_z - 1;
+    const uint32_t k_max_x = size_x - 1;
+    const uint32_t k_max_y = size_y - 1;
+    const uint32_t k_max_z = size_z - 1;
     
-    const uint8_t* current_voxel = voxels;
+    const uint8_t* current_voxel = voxels + (size_t)k_begin * k_stride_z;
 
-    uint32_t total_vertex_count = 0;
-    uint32_t total_index_count = 0;
-    for (uint32_t k = 0; k < size_z; k++)
+    for (uint32_t k = k_begin; k < k_end; k++)
     {
-        const float min_z = (float)k;
-        const float max_z = min_z + 1.0f;
         for (uint32_t j = 0; j < size_y; j++)
         {
-            const float min_y = (float)j;
-            const float max_y = min_y + 1.0f;
             for (uint32_t i = 0; i < size_x; i++, current_voxel++)
             {
                 // current voxel slot is empty? skip it.
                 if (current_voxel[0] == 0)
                     continue;
 
-                ogt_mesh_rgba color = palette[ current_voxel[0]];
-                
-                // determine the min/max coords of the voxel for each dimension.
-                const float min_x = (float)i;
-                const float max_x = min_x + 1.0f;
-
                 // determine which faces we need to generate
                 uint32_t neg_x = ((i == 0)       || (current_voxel[-k_stride_x] == 0));
                 uint32_t pos_x = ((i == k_max_x) || (current_voxel[ k_stride_x] == 0));
@@ -629,136 +1028,261 @@ void ogt_stream_from_paletted_voxels_simple(
                 uint32_t neg_z = ((k == 0)       || (current_voxel[-k_stride_z] == 0));
                 uint32_t pos_z = ((k == k_max_z) || (current_voxel[ k_stride_z] == 0));
 
-                // count the number of faces. skip if zero.
-                const uint32_t face_count_needed = (neg_x + pos_x + neg_y + pos_y + neg_z + pos_z);
-                if (!face_count_needed)
-                    continue;
+                visit_func(i, j, k, current_voxel[0], neg_x, pos_x, neg_y, pos_y, neg_z, pos_z);
+            }
+        }
+    }	
 
-                // generate geometry for this voxel to a local buffer first.
-                ogt_mesh_vertex  local_vertex[24];
-                uint32_t         local_index[36];
-                ogt_mesh_vertex* current_vertex = local_vertex;
-                uint32_t*        current_index  = local_index;
+}
 
-                // -X direction face
-                if (neg_x)
-                {
-                    current_vertex[0] = _mesh_make_vertex( min_x, min_y, min_z, -1.0f, 0.0f, 0.0f, color );
-                    current_vertex[1] = _mesh_make_vertex( min_x, max_y, min_z, -1.0f, 0.0f, 0.0f, color );
-                    current_vertex[2] = _mesh_make_vertex( min_x, max_y, max_z, -1.0f, 0.0f, 0.0f, color );
-                    current_vertex[3] = _mesh_make_vertex( min_x, min_y, max_z, -1.0f, 0.0f, 0.0f, color );
-                    current_index[0] = total_vertex_count + 2;
-                    current_index[1] = total_vertex_count + 1;
-                    current_index[2] = total_vertex_count + 0;
-                    current_index[3] = total_vertex_count + 0;
-                    current_index[4] = total_vertex_count + 3;
-                    current_index[5] = total_vertex_count + 2;
-                    total_vertex_count += 4;
-                    total_index_count  += 6;
-                    current_vertex += 4;
-                    current_index += 6;
-                }
-                
-                // +X direction face
-                if (pos_x)
-                {
-                    current_vertex[0] = _mesh_make_vertex( max_x, min_y, min_z, 1.0f, 0.0f, 0.0f, color );
-                    current_vertex[1] = _mesh_make_vertex( max_x, max_y, min_z, 1.0f, 0.0f, 0.0f, color );
-                    current_vertex[2] = _mesh_make_vertex( max_x, max_y, max_z, 1.0f, 0.0f, 0.0f, color );
-                    current_vertex[3] = _mesh_make_vertex( max_x, min_y, max_z, 1.0f, 0.0f, 0.0f, color );
-                    current_index[0] = total_vertex_count + 0;
-                    current_index[1] = total_vertex_count + 1;
-                    current_index[2] = total_vertex_count + 2;
-                    current_index[3] = total_vertex_count + 2;
-                    current_index[4] = total_vertex_count + 3;
-                    current_index[5] = total_vertex_count + 0;
-                    total_vertex_count += 4;
-                    total_index_count  += 6;
-                    current_vertex += 4;
-                    current_index += 6;
-                }
-                
-                // -Y direction face
-                if (neg_y)
-                {
-                    current_vertex[0] = _mesh_make_vertex( min_x, min_y, min_z, 0.0f,-1.0f, 0.0f, color );
-                    current_vertex[1] = _mesh_make_vertex( max_x, min_y, min_z, 0.0f,-1.0f, 0.0f, color );
-                    current_vertex[2] = _mesh_make_vertex( max_x, min_y, max_z, 0.0f,-1.0f, 0.0f, color );
-                    current_vertex[3] = _mesh_make_vertex( min_x, min_y, max_z, 0.0f,-1.0f, 0.0f, color );
-                    current_index[0] = total_vertex_count + 0;
-                    current_index[1] = total_vertex_count + 1;
-                    current_index[2] = total_vertex_count + 2;
-                    current_index[3] = total_vertex_count + 2;
-                    current_index[4] = total_vertex_count + 3;
-                    current_index[5] = total_vertex_count + 0;
-                    total_vertex_count += 4;
-                    total_index_count  += 6;
-                    current_vertex += 4;
-                    current_index += 6;
-                }
-                // +Y direction face
-                if (pos_y)
-                {
-                    current_vertex[0] = _mesh_make_vertex( min_x, max_y, min_z, 0.0f, 1.0f, 0.0f, color );
-                    current_vertex[1] = _mesh_make_vertex( max_x, max_y, min_z, 0.0f, 1.0f, 0.0f, color );
-                    current_vertex[2] = _mesh_make_vertex( max_x, max_y, max_z, 0.0f, 1.0f, 0.0f, color );
-                    current_vertex[3] = _mesh_make_vertex( min_x, max_y, max_z, 0.0f, 1.0f, 0.0f, color );
-                    current_index[0] = total_vertex_count + 2;
-                    current_index[1] = total_vertex_count + 1;
-                    current_index[2] = total_vertex_count + 0;
-                    current_index[3] = total_vertex_count + 0;
-                    current_index[4] = total_vertex_count + 3;
-                    current_index[5] = total_vertex_count + 2;
-                    total_vertex_count += 4;
-                    total_index_count  += 6;
-                    current_vertex += 4;
-                    current_index += 6;
-               }
-                // -Z direction face
-                if (neg_z)
-                {
-                    current_vertex[0] = _mesh_make_vertex( min_x, min_y, min_z, 0.0f, 0.0f,-1.0f, color );
-                    current_vertex[1] = _mesh_make_vertex( max_x, min_y, min_z, 0.0f, 0.0f,-1.0f, color );
-                    current_vertex[2] = _mesh_make_vertex( max_x, max_y, min_z, 0.0f, 0.0f,-1.0f, color );
-                    current_vertex[3] = _mesh_make_vertex( min_x, max_y, min_z, 0.0f, 0.0f,-1.0f, color );
-                    current_index[0] = total_vertex_count + 2;
-                    current_index[1] = total_vertex_count + 1;
-                    current_index[2] = total_vertex_count + 0;
-                    current_index[3] = total_vertex_count + 0;
-                    current_index[4] = total_vertex_count + 3;
-                    current_index[5] = total_vertex_count + 2;
-                    total_vertex_count += 4;
-                    total_index_count  += 6;
-                    current_vertex += 4;
-                    current_index += 6;
-                }
-                // +Z direction face
-                if (pos_z)
-                {
-                    current_vertex[0] = _mesh_make_vertex( min_x, min_y, max_z, 0.0f, 0.0f, 1.0f, color );
-                    current_vertex[1] = _mesh_make_vertex( max_x, min_y, max_z, 0.0f, 0.0f, 1.0f, color );
-                    current_vertex[2] = _mesh_make_vertex( max_x, max_y, max_z, 0.0f, 0.0f, 1.0f, color );
-                    current_vertex[3] = _mesh_make_vertex( min_x, max_y, max_z, 0.0f, 0.0f, 1.0f, color );
-                    current_index[0] = total_vertex_count + 0;
-                    current_index[1] = total_vertex_count + 1;
-                    current_index[2] = total_vertex_count + 2;
-                    current_index[3] = total_vertex_count + 2;
-                    current_index[4] = total_vertex_count + 3;
-                    current_index[5] = total_vertex_count + 0;
-                    total_vertex_count += 4;
-                    total_index_count  += 6;
-                    current_vertex += 4;
-                    current_index += 6;
-                }
+// shared state of the tasks of the simple mesher when it runs on a job system. Each task covers a range of z slices.
+struct _simple_parallel_task_data {
+    const uint8_t*       voxels;
+    uint32_t             size_x, size_y, size_z;
+    uint32_t             slices_per_range;
+    uint32_t*            range_first_face;      // the faces of each range start here in the mesh, once the face counts are summed.
+    const _mesh_writer*  out;
+};
+
+// counts the faces of a range.
+static void _simple_parallel_count_task(void* task_data, uint32_t task_index) {
+    _simple_parallel_task_data* data = (_simple_parallel_task_data*)task_data;
+    uint32_t k_begin = task_index * data->slices_per_range;
+    uint32_t k_end   = data->size_z - k_begin < data->slices_per_range ? data->size_z : k_begin + data->slices_per_range;
+    data->range_first_face[task_index + 1] = _count_voxel_sized_faces_in_z_slices(data->voxels, data->size_x, data->size_y, data->size_z, k_begin, k_end);
+}
+
+// writes the faces of a range into their place in the mesh.
+static void _simple_parallel_write_task(void* task_data, uint32_t task_index) {
+    _simple_parallel_task_data* data = (_simple_parallel_task_data*)task_data;
+    uint32_t k_begin = task_index * data->slices_per_range;
+    uint32_t k_end   = data->size_z - k_begin < data->slices_per_range ? data->size_z : k_begin + data->slices_per_range;
+    _mesh_writer range_out = *data->out;
+    range_out.vertex_count = data->range_first_face[task_index] * 4;
+    range_out.index_count  = data->range_first_face[task_index] * 6;
+    _voxel_face_writer writer;
+    writer.out = &range_out;
+    _visit_paletted_voxel_faces(data->voxels, data->size_x, data->size_y, data->size_z, k_begin, k_end, writer);
+}
+
+// the simple mesher on a job system. Every voxel's faces only depend on the voxel and its neighbors, so each range of z slices is counted,
+// and then written straight into its place in the mesh.
+static void* _mesh_from_paletted_voxels_simple_parallel(
+    const ogt_voxel_meshify_context* ctx, const _mesh_job_system& jobs, uint32_t slices_per_range, uint32_t range_count,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, _mesh_writer& out)
+{
+    uint32_t* range_first_face = (uint32_t*)_voxel_meshify_malloc(ctx, sizeof(uint32_t) * (range_count + 1));
+    if (!range_first_face)
+        return NULL;
+
+    _simple_parallel_task_data task_data;
+    task_data.voxels           = voxels;
+    task_data.size_x           = size_x;
+    task_data.size_y           = size_y;
+    task_data.size_z           = size_z;
+    task_data.slices_per_range = slices_per_range;
+    task_data.range_first_face = range_first_face;
+    task_data.out              = &out;
+    _mesh_run_tasks(jobs, _simple_parallel_count_task, &task_data, range_count);
+
+    range_first_face[0] = 0;
+    for (uint32_t range_index = 0; range_index < range_count; range_index++)
+        range_first_face[range_index + 1] += range_first_face[range_index];
+
+    uint32_t face_count = range_first_face[range_count];
+    void* mesh = _mesh_writer_alloc(ctx, out, face_count * 4, face_count * 6);
+    if (mesh) {
+        _mesh_run_tasks(jobs, _simple_parallel_write_task, &task_data, range_count);
+        out.vertex_count = face_count * 4;
+        out.index_count  = face_count * 6;
+        _mesh_writer_finish(mesh, out);
+    }
+    _voxel_meshify_free(ctx, range_first_face);
+    return mesh;
+}
+
+// the simple mesher, writing the mesh through out.
+static void* _mesh_from_paletted_voxels_simple(
+    const ogt_voxel_meshify_context* ctx,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, _mesh_writer& out)
+{
+    // spread the work across the job system if the context has one, and there is enough work to split.
+    _mesh_job_system jobs = _make_job_system(ctx, NULL, NULL, NULL);
+    if (jobs.submit_func && size_x && size_y) {
+        uint32_t slices_per_range = _mesh_slices_per_range(size_x * size_y);
+        uint32_t range_count = (size_z + slices_per_range - 1) / slices_per_range;
+        if (range_count > 1)
+            return _mesh_from_paletted_voxels_simple_parallel(ctx, jobs, slices_per_range, range_count, voxels, size_x, size_y, size_z, out);
+    }
+
+    uint32_t max_face_count   = _count_voxel_sized_faces( voxels, size_x, size_y, size_z );
+    uint32_t max_vertex_count = max_face_count * 4;
+    uint32_t max_index_count  = max_face_count * 6;
+    
+    void* mesh = _mesh_writer_alloc(ctx, out, max_vertex_count, max_index_count);
+    if (!mesh)
+        return NULL;
+    
+    _voxel_face_writer writer;
+    writer.out = &out;
+    _visit_paletted_voxel_faces(voxels, size_x, size_y, size_z, 0, size_z, writer);
+    
+    assert( out.vertex_count == max_vertex_count);
+    assert( out.index_count == max_index_count);	
+    return _mesh_writer_finish(mesh, out);
+}
+
+// constructs and returns a mesh from the specified voxel grid with no optimization to the geometry.
+ogt_mesh* ogt_mesh_from_paletted_voxels_simple(
+    const ogt_voxel_meshify_context* ctx,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette) 
+{
+    _mesh_writer out = _make_mesh_writer(palette);
+    return (ogt_mesh*)_mesh_from_paletted_voxels_simple(ctx, voxels, size_x, size_y, size_z, out);
+}
+
+// streams geometry for each voxel at a time to a specified user function.
+void ogt_stream_from_paletted_voxels_simple(
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette,
+    ogt_voxel_simple_stream_func stream_func, void* stream_func_data) 
+{
+    assert(stream_func);
+    _voxel_face_streamer streamer;
+    streamer.palette            = palette;
+    streamer.stream_func        = stream_func;
+    streamer.stream_func_data   = stream_func_data;
+    streamer.total_vertex_count = 0;
+    _visit_paletted_voxel_faces(voxels, size_x, size_y, size_z, 0, size_z, streamer);
+}
+
+// walks the solid voxels of a row in a sparse voxel field in increasing x order, to find which of them are solid.
+struct _mesh_packed_row_cursor {
+    const ogt_mesh_packed_voxel* current;
+    const ogt_mesh_packed_voxel* end;
+    // an empty cursor is used for rows outside the grid, so all voxels there are considered empty.
+    void init_empty() { current = end = NULL; }
+    void init(const ogt_mesh_packed_voxel* voxels, const uint32_t* row_offsets, uint32_t row) {
+        current = &voxels[row_offsets[row]];
+        end     = &voxels[row_offsets[row + 1]];
+    }
+    // returns whether the voxel at x in this row is solid. x must not decrease between calls.
+    bool is_solid(uint32_t x) {
+        while (current < end && current->x < x)
+            current++;
+        return current < end && current->x == x;
+    }
+};
 
-                // geometry for this voxel is provided to a caller-specified stream function/callback
-                stream_func(i, j, k, local_vertex, face_count_needed*4, local_index, face_count_needed*6, stream_func_data);
+// determines which faces are needed for every solid voxel of a row in a sparse voxel field, and calls visit_func on each of them.
+// Neighbors on y and z are found by walking the 4 adjacent rows alongside this one, so each row is visited in linear time.
+template<class VISIT_FUNC>
+static void _visit_packed_voxel_faces(const ogt_mesh_packed_voxel* voxels, const uint32_t* row_offsets, uint32_t size_x, uint32_t size_y, uint32_t size_z, VISIT_FUNC& visit_func) {
+    const uint32_t k_max_x = size_x - 1;
+    const uint32_t k_max_y = size_y - 1;
+    const uint32_t k_max_z = size_z - 1;
+    for (uint32_t k = 0; k < size_z; k++) {
+        for (uint32_t j = 0; j < size_y; j++) {
+            const uint32_t row       = j + k * size_y;
+            const uint32_t row_begin = row_offsets[row];
+            const uint32_t row_end   = row_offsets[row + 1];
+            if (row_begin == row_end)
+                continue;
+            _mesh_packed_row_cursor neg_y_row, pos_y_row, neg_z_row, pos_z_row;
+            if (j > 0)       neg_y_row.init(voxels, row_offsets, row - 1);      else neg_y_row.init_empty();
+            if (j < k_max_y) pos_y_row.init(voxels, row_offsets, row + 1);      else pos_y_row.init_empty();
+            if (k > 0)       neg_z_row.init(voxels, row_offsets, row - size_y); else neg_z_row.init_empty();
+            if (k < k_max_z) pos_z_row.init(voxels, row_offsets, row + size_y); else pos_z_row.init_empty();
+            for (uint32_t v = row_begin; v < row_end; v++) {
+                const uint32_t i = voxels[v].x;
+                assert(voxels[v].color_index != 0 && i < size_x);
+                // voxels within the row are sorted on x, so neighbors on x are adjacent in the array if they're solid.
+                uint32_t neg_x = ((i == 0)       || (v == row_begin)   || (voxels[v - 1].x != i - 1));
+                uint32_t pos_x = ((i == k_max_x) || (v + 1 == row_end) || (voxels[v + 1].x != i + 1));
+                uint32_t neg_y = !neg_y_row.is_solid(i);
+                uint32_t pos_y = !pos_y_row.is_solid(i);
+                uint32_t neg_z = !neg_z_row.is_solid(i);
+                uint32_t pos_z = !pos_z_row.is_solid(i);
+                visit_func(i, j, k, voxels[v].color_index, neg_x, pos_x, neg_y, pos_y, neg_z, pos_z);
             }
         }
-    }	
+    }
+}
+
+// counts the faces that are needed for each voxel visited by _visit_packed_voxel_faces
+struct _packed_voxel_face_counter {
+    uint32_t face_count;
+    void operator()(uint32_t, uint32_t, uint32_t, uint8_t, uint32_t neg_x, uint32_t pos_x, uint32_t neg_y, uint32_t pos_y, uint32_t neg_z, uint32_t pos_z) {
+        face_count += neg_x + pos_x + neg_y + pos_y + neg_z + pos_z;
+    }
+};
+
+// returns the number of quad faces that would be generated by tessellating the specified sparse voxel field using the simple algorithm.
+uint32_t ogt_face_count_from_packed_voxels_simple(const ogt_mesh_packed_voxel* voxels, const uint32_t* row_offsets, uint32_t size_x, uint32_t size_y, uint32_t size_z)
+{
+    _packed_voxel_face_counter counter;
+    counter.face_count = 0;
+    _visit_packed_voxel_faces(voxels, row_offsets, size_x, size_y, size_z, counter);
+    return counter.face_count;
+}
+
+// constructs and returns a mesh from the specified sparse voxel field with no optimization to the geometry.
+ogt_mesh* ogt_mesh_from_packed_voxels_simple(
+    const ogt_voxel_meshify_context* ctx,
+    const ogt_mesh_packed_voxel* voxels, const uint32_t* row_offsets, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette)
+{
+    uint32_t max_face_count   = ogt_face_count_from_packed_voxels_simple( voxels, row_offsets, size_x, size_y, size_z );
+    uint32_t max_vertex_count = max_face_count * 4;
+    uint32_t max_index_count  = max_face_count * 6;
+
+    _mesh_writer out = _make_mesh_writer(palette);
+    ogt_mesh* mesh = (ogt_mesh*)_mesh_writer_alloc(ctx, out, max_vertex_count, max_index_count);
+    if (!mesh)
+        return NULL;
+
+    _voxel_face_writer writer;
+    writer.out = &out;
+    _visit_packed_voxel_faces(voxels, row_offsets, size_x, size_y, size_z, writer);
+
+    assert( out.vertex_count == max_vertex_count);
+    assert( out.index_count == max_index_count);
+    return (ogt_mesh*)_mesh_writer_finish(mesh, out);
+}
+
+// streams geometry for each solid voxel of a sparse voxel field at a time to a specified user function.
+void ogt_stream_from_packed_voxels_simple(
+    const ogt_mesh_packed_voxel* voxels, const uint32_t* row_offsets, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette,
+    ogt_voxel_simple_stream_func stream_func, void* stream_func_data)
+{
+    assert(stream_func);
+    _voxel_face_streamer streamer;
+    streamer.palette            = palette;
+    streamer.stream_func        = stream_func;
+    streamer.stream_func_data   = stream_func_data;
+    streamer.total_vertex_count = 0;
+    _visit_packed_voxel_faces(voxels, row_offsets, size_x, size_y, size_z, streamer);
+}
+
 
+// writes the 4 vertices and 6 indices of a greedy quad that covers [min_x,max_x] x [min_y,max_y] at max_z in face space.
+static void _greedy_write_quad(_mesh_writer& out, const ogt_mesh_transform& transform, uint32_t face, bool is_parity_flipped,
+    float min_x, float max_x, float min_y, float max_y, float max_z, uint8_t color_index)
+{
+    // reverse the index order to ensure parity/winding is still correct.
+    _mesh_write_quad(out,
+        _transform_point(transform, _make_vec3(min_x, min_y, max_z)),
+        _transform_point(transform, _make_vec3(max_x, min_y, max_z)),
+        _transform_point(transform, _make_vec3(max_x, max_y, max_z)),
+        _transform_point(transform, _make_vec3(min_x, max_y, max_z)),
+        face, color_index, is_parity_flipped ? k_mesh_quad_corners_flipped : k_mesh_quad_corners);
 }
 
+// returns whether the transform has flipped parity in a way that winding would have been switched.
+static bool _is_transform_parity_flipped(const ogt_mesh_transform& transform) {
+    const ogt_mesh_vec3* side = _make_vec3_ptr(&transform.m00);
+    const ogt_mesh_vec3* up   = _make_vec3_ptr(&transform.m10);
+    const ogt_mesh_vec3* fwd  = _make_vec3_ptr(&transform.m20);
+    return _dot3(*fwd, _cross3(*side, *up)) < 0.0f;
+}
 
 // The base algorithm that is used here, is as follows:
 // On a per slice basis, we find a voxel that has not yet been polygonized. We then try to 
@@ -768,11 +1292,10 @@ void ogt_stream_from_paletted_voxels_simple(
 // the rest of the slice.
 void _greedy_meshify_voxels_in_face_direction(
     const uint8_t* voxels,
-    const ogt_mesh_rgba* palette,
     int32_t size_x, int32_t size_y, int32_t size_z,                // how many voxels in each of X,Y,Z dimensions
     int32_t k_stride_x, int32_t k_stride_y, int32_t k_stride_z,            // the memory stride for each of those X,Y,Z dimensions within the voxel data.
     const ogt_mesh_transform& transform,                                    // transform to convert from X,Y,Z to "objectSpace"
-    ogt_mesh* out_mesh)
+    _mesh_writer& out)
 {
 
     // enable aggressive voxel optimization for now.
@@ -782,22 +1305,13 @@ void _greedy_meshify_voxels_in_face_direction(
     assert(max_voxels_per_slice <= 65536);	// 
     ogt_mesh_bitset_64k voxel_polygonized;
 
-    ogt_mesh_vec3 normal = _transform_vector(transform, _make_vec3(0.0f, 0.0f, 1.0f));
+    uint32_t face = _mesh_face_from_normal(_transform_vector(transform, _make_vec3(0.0f, 0.0f, 1.0f)));
 
 #define VOXELDATA_INDEX(_x,_y,_z)        ((_x) * k_stride_x) + ((_y) * k_stride_y) + ((_z) * k_stride_z)
 #define LOCALDATA_INDEX(_x,_y)            ((_x) + ((_y) * size_x))
 
-    // use this to remap parity where necessary.
-    uint32_t base_index_start = out_mesh->index_count;
-
-    uint32_t* index_data         = &out_mesh->indices[out_mesh->index_count];
-    ogt_mesh_vertex* vertex_data = &out_mesh->vertices[out_mesh->vertex_count];
-
     // determine if the transform parity has flipped in a way that winding would have been switched.
-    const ogt_mesh_vec3* side = _make_vec3_ptr(&transform.m00);
-    const ogt_mesh_vec3* up   = _make_vec3_ptr(&transform.m10);
-    const ogt_mesh_vec3* fwd  = _make_vec3_ptr(&transform.m20);
-    bool is_parity_flipped = _dot3(*fwd, _cross3(*side, *up)) < 0.0f;
+    bool is_parity_flipped = _is_transform_parity_flipped(transform);
 
     for (int32_t k0 = 0; k0 < size_z; k0++) {
         // k0 = current slice, k1 = next slice
@@ -868,38 +1382,7 @@ void _greedy_meshify_voxels_in_face_direction(
                 float max_y = (float)j1;
                 float max_z = (float)k1;
 
-                // cache the color
-                ogt_mesh_rgba color = palette[color_index];
-
-                // write the verts for this face
-                vertex_data[0] = _mesh_make_vertex(_transform_point(transform, _make_vec3(min_x, min_y, max_z)), normal, color);
-                vertex_data[1] = _mesh_make_vertex(_transform_point(transform, _make_vec3(max_x, min_y, max_z)), normal, color);
-                vertex_data[2] = _mesh_make_vertex(_transform_point(transform, _make_vec3(max_x, max_y, max_z)), normal, color);
-                vertex_data[3] = _mesh_make_vertex(_transform_point(transform, _make_vec3(min_x, max_y, max_z)), normal, color);
-
-                // reserve the index order to ensure parity/winding is still correct.
-                if (is_parity_flipped) {
-                    index_data[0] = out_mesh->vertex_count + 0;
-                    index_data[1] = out_mesh->vertex_count + 3;
-                    index_data[2] = out_mesh->vertex_count + 2;
-                    index_data[3] = out_mesh->vertex_count + 2;
-                    index_data[4] = out_mesh->vertex_count + 1;
-                    index_data[5] = out_mesh->vertex_count + 0;
-                }
-                else {
-                    index_data[0] = out_mesh->vertex_count + 0;
-                    index_data[1] = out_mesh->vertex_count + 1;
-                    index_data[2] = out_mesh->vertex_count + 2;
-                    index_data[3] = out_mesh->vertex_count + 2;
-                    index_data[4] = out_mesh->vertex_count + 3;
-                    index_data[5] = out_mesh->vertex_count + 0;
-                }
-
-                vertex_data += 4;
-                index_data  += 6;
-
-                out_mesh->vertex_count += 4;
-                out_mesh->index_count += 6;
+                _greedy_write_quad(out, transform, face, is_parity_flipped, min_x, max_x, min_y, max_y, max_z, color_index);
             }
         }
     }
@@ -909,127 +1392,614 @@ void _greedy_meshify_voxels_in_face_direction(
 
 }
 
+// the local axes that the greedy and polygon meshers use for one of the 6 face directions, and the transform from them to object space.
+struct _mesh_face_axes {
+    uint32_t axis_i, axis_j, axis_k;        // which of x=0, y=1, z=2 each local axis runs along. Faces point along k.
+    int32_t  size_i, size_j, size_k;        // how many voxels along each local axis.
+    int32_t  stride_i, stride_j, stride_k;  // the memory stride for each local axis within the voxel data.
+    int32_t  origin;                        // the offset of voxel (0,0,0) in local axes within the voxel data.
+    bool     is_negative;                   // true if faces point along -k, in which case k runs from the far end of the grid.
+    ogt_mesh_transform transform;           // transform to convert from i,j,k to object space.
+};
+
+// returns the local axes of the specified face direction, in the order +Y, -Y, +X, -X, +Z, -Z.
+static _mesh_face_axes _get_mesh_face_axes(uint32_t face_index, uint32_t size_x, uint32_t size_y, uint32_t size_z) {
+    const int32_t sizes[3] = { (int32_t)size_x, (int32_t)size_y, (int32_t)size_z };
+    _mesh_face_axes axes;
+    axes.is_negative = (face_index & 1) ? true : false;
+    switch (face_index >> 1) {
+        case 0: // Y faces
+            axes.axis_i = 2; axes.axis_j = 0; axes.axis_k = 1;
+            axes.transform = axes.is_negative ?
+                _make_transform(
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                    1.0f, 0.0f, 0.0f, 0.0f,
+                    0.0f,-1.0f, 0.0f, 0.0f,
+                    0.0f, (float)(size_y), 0.0f, 0.0f) :
+                _make_transform(
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                    1.0f, 0.0f, 0.0f, 0.0f,
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f, 0.0f);
+            break;
+        case 1: // X faces
+            axes.axis_i = 1; axes.axis_j = 2; axes.axis_k = 0;
+            axes.transform = axes.is_negative ?
+                _make_transform(
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                   -1.0f, 0.0f, 0.0f, 0.0f,
+                (float)size_x, 0.0f, 0.0f, 0.0f) :
+                _make_transform(
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                    1.0f, 0.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f, 0.0f);
+            break;
+        default: // Z faces
+            axes.axis_i = 0; axes.axis_j = 1; axes.axis_k = 2;
+            axes.transform = axes.is_negative ?
+                _make_transform(
+                    1.0f, 0.0f, 0.0f, 0.0f,
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, -1.0f, 0.0f,
+                    0.0f, 0.0f,(float)size_z, 0.0f) :
+                _make_transform(
+                    1.0f, 0.0f, 0.0f, 0.0f,
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f, 0.0f);
+            break;
+    }
+    const int32_t strides[3] = { 1, (int32_t)size_x, (int32_t)(size_x * size_y) };
+    axes.size_i   = sizes[axes.axis_i];
+    axes.size_j   = sizes[axes.axis_j];
+    axes.size_k   = sizes[axes.axis_k];
+    axes.stride_i = strides[axes.axis_i];
+    axes.stride_j = strides[axes.axis_j];
+    axes.stride_k = axes.is_negative ? -strides[axes.axis_k] : strides[axes.axis_k];
+    axes.origin   = axes.is_negative ? (axes.size_k - 1) * strides[axes.axis_k] : 0;
+    return axes;
+}
+
+// a range of slices of one face direction, which the parallel meshers mesh as a task independently of all others.
+struct _mesh_slice_range {
+    uint32_t face_index;        // the face direction, in the order of _get_mesh_face_axes
+    uint32_t k_begin, k_end;    // the slices, in the order that the face direction visits them
+};
+
+// splits every face_step'th face direction from the first into ranges of slices that are each worth a task, in the order that the
+// serial meshers visit them. Returns the number of ranges, and only writes them if ranges is non-NULL.
+static uint32_t _mesh_split_slice_ranges(uint32_t size_x, uint32_t size_y, uint32_t size_z, uint32_t face_step, _mesh_slice_range* ranges) {
+    uint32_t range_count = 0;
+    for (uint32_t face_index = 0; face_index < 6; face_index += face_step) {
+        _mesh_face_axes axes = _get_mesh_face_axes(face_index, size_x, size_y, size_z);
+        uint32_t slice_size = (uint32_t)(axes.size_i * axes.size_j);
+        uint32_t slices_per_range = _mesh_slices_per_range(slice_size);
+        for (uint32_t k = 0; k < (uint32_t)axes.size_k && slice_size; k += slices_per_range) {
+            if (ranges) {
+                ranges[range_count].face_index = face_index;
+                ranges[range_count].k_begin    = k;
+                ranges[range_count].k_end      = (uint32_t)axes.size_k - k < slices_per_range ? (uint32_t)axes.size_k : k + slices_per_range;
+            }
+            range_count++;
+        }
+    }
+    return range_count;
+}
+
 ogt_mesh* ogt_mesh_from_paletted_voxels_greedy(
     const ogt_voxel_meshify_context* ctx,
     const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette) 
 {
+    // the parallel greedy mesher produces the same mesh, so use it whenever the context has a job system.
+    if (ctx->job_submit_func)
+        return ogt_mesh_from_paletted_voxels_greedy_parallel(ctx, voxels, size_x, size_y, size_z, palette, NULL, NULL, NULL);
+
     uint32_t max_face_count   = _count_voxel_sized_faces( voxels, size_x, size_y, size_z );
     uint32_t max_vertex_count = max_face_count * 4;
     uint32_t max_index_count  = max_face_count * 6;
     
-    uint32_t mesh_size = sizeof(ogt_mesh) + (max_vertex_count * sizeof(ogt_mesh_vertex)) + (max_index_count * sizeof(uint32_t));
-    ogt_mesh* mesh = (ogt_mesh*)_voxel_meshify_malloc(ctx, mesh_size);
+    _mesh_writer out = _make_mesh_writer(palette);
+    ogt_mesh* mesh = (ogt_mesh*)_mesh_writer_alloc(ctx, out, max_vertex_count, max_index_count);
     if (!mesh)
         return NULL;
     
-    mesh->vertices = (ogt_mesh_vertex*)&mesh[1];
-    mesh->indices  = (uint32_t*)&mesh->vertices[max_vertex_count];
-    mesh->vertex_count = 0;
-    mesh->index_count  = 0;
-    
-    const int32_t k_stride_x = 1;
-    const int32_t k_stride_y = size_x;
-    const int32_t k_stride_z = size_x * size_y;
-    
-    // do the +y PASS
-    {
-        ogt_mesh_transform transform_pos_y = _make_transform(
-            0.0f, 0.0f, 1.0f, 0.0f,
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 0.0f, 0.0f);
-
+    // do the +Y, -Y, +X, -X, +Z, -Z passes in that order. Each face direction meshes slices along its own local
+    // i,j,k axes, and the negative directions walk their slices from the far end of the grid.
+    for (uint32_t face_index = 0; face_index < 6; face_index++) {
+        _mesh_face_axes axes = _get_mesh_face_axes(face_index, size_x, size_y, size_z);
         _greedy_meshify_voxels_in_face_direction(
-            voxels, palette,
-            size_z, size_x, size_y,
-            k_stride_z, k_stride_x, k_stride_y,
-            transform_pos_y,
-            mesh);
+            voxels + axes.origin,
+            axes.size_i, axes.size_j, axes.size_k,
+            axes.stride_i, axes.stride_j, axes.stride_k,
+            axes.transform,
+            out);
     }
-    // do the -y PASS
-    {
-        ogt_mesh_transform transform_neg_y = _make_transform(
-            0.0f, 0.0f, 1.0f, 0.0f,
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f,-1.0f, 0.0f, 0.0f,
-            0.0f, (float)(size_y), 0.0f, 0.0f);
 
-        _greedy_meshify_voxels_in_face_direction(
-            voxels + (size_y - 1) * k_stride_y, 
-            palette,
-            size_z, size_x, size_y,
-            k_stride_z, k_stride_x,-k_stride_y,
-            transform_neg_y,
-            mesh);
-    }
-    // do the +X pass
-    {
-        ogt_mesh_transform transform_pos_x = _make_transform(
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 0.0f, 0.0f);
+    assert( out.vertex_count <= max_vertex_count);
+    assert( out.index_count <= max_index_count);	
+    return (ogt_mesh*)_mesh_writer_finish(mesh, out);
+}
 
-        _greedy_meshify_voxels_in_face_direction(
-            voxels, palette,
-            size_y, size_z, size_x,
-            k_stride_y, k_stride_z, k_stride_x,
-            transform_pos_x,
-            mesh);
+// returns the index of the lowest set bit. bits must not be 0.
+static inline uint32_t _mesh_lowest_bit_index(uint64_t bits) {
+    assert(bits != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctzll(bits);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long)bits))
+        return (uint32_t)index;
+    _BitScanForward(&index, (unsigned long)(bits >> 32));
+    return (uint32_t)index + 32;
+#else
+    uint32_t index = 0;
+    for (; !(bits & 1); bits >>= 1)
+        index++;
+    return index;
+#endif
+}
+
+// returns a mask of the bits from first_bit up to but excluding end_bit within the 64-bit word that starts at word_bit.
+static inline uint64_t _mesh_word_bit_range(uint32_t word_bit, uint32_t first_bit, uint32_t end_bit) {
+    uint32_t first = first_bit > word_bit ? first_bit - word_bit : 0;
+    uint32_t end   = end_bit - word_bit < 64 ? end_bit - word_bit : 64;
+    uint64_t mask  = end == 64 ? ~(uint64_t)0 : (((uint64_t)1 << end) - 1);
+    return mask & ~(((uint64_t)1 << first) - 1);
+}
+
+// builds a mask of which voxels in a row of color indices are solid, 1 bit per voxel.
+static void _mesh_build_solid_row_mask(const uint8_t* colors, uint32_t size, uint64_t* mask) {
+    const uint64_t k_low_7_bits = 0x7F7F7F7F7F7F7F7Full;
+    const uint64_t k_low_bits   = 0x0101010101010101ull;
+    for (uint32_t word_bit = 0; word_bit < size; word_bit += 64) {
+        uint32_t word_end = size - word_bit < 64 ? size : word_bit + 64;
+        uint64_t bits = 0;
+        uint32_t i = word_bit;
+#if defined(_MESH_HAVE_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= word_end; i += 16) {
+            uint32_t empty_bits = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&colors[i]), zero));
+            bits |= (uint64_t)(~empty_bits & 0xFFFF) << (i - word_bit);
+        }
+#endif
+        for (; i + 8 <= word_end; i += 8) {
+            // set the top bit of each non-zero byte, then gather those 8 top bits into 8 adjacent bits.
+            uint64_t eight_colors;
+            memcpy(&eight_colors, &colors[i], 8);
+            uint64_t top_bits = (((eight_colors & k_low_7_bits) + k_low_7_bits) | eight_colors) & ~k_low_7_bits;
+            bits |= ((((top_bits >> 7) & k_low_bits) * 0x0102040810204080ull) >> 56) << (i - word_bit);
+        }
+        for (; i < word_end; i++)
+            bits |= (uint64_t)(colors[i] != 0) << (i - word_bit);
+        mask[word_bit >> 6] = bits;
     }
-    // do the -X pass
-    {
-        ogt_mesh_transform transform_neg_x = _make_transform(
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-           -1.0f, 0.0f, 0.0f, 0.0f,
-        (float)size_x, 0.0f, 0.0f, 0.0f);
+}
 
-        _greedy_meshify_voxels_in_face_direction(
-            voxels + (size_x - 1) * k_stride_x,
-            palette,
-            size_y, size_z, size_x,
-            k_stride_y, k_stride_z, -k_stride_x,
-            transform_neg_x,
-            mesh);
-    }
-    // do the +Z pass
-    {
-        ogt_mesh_transform transform_pos_z = _make_transform(
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-            0.0f, 0.0f, 0.0f, 0.0f);
+// returns the first index from first up to end where the color differs from color_index, or end if they all match.
+static uint32_t _mesh_find_color_mismatch(const uint8_t* colors, uint32_t first, uint32_t end, uint8_t color_index) {
+    const uint64_t pattern = (uint64_t)color_index * 0x0101010101010101ull;
+    for (; first + 8 <= end; first += 8) {
+        uint64_t eight_colors;
+        memcpy(&eight_colors, &colors[first], 8);
+        if (eight_colors != pattern)
+            return first + (_mesh_lowest_bit_index(eight_colors ^ pattern) >> 3);
+    }
+    while (first < end && colors[first] == color_index)
+        first++;
+    return first;
+}
 
-        _greedy_meshify_voxels_in_face_direction(
-            voxels, palette,
-            size_x, size_y, size_z,
-            k_stride_x, k_stride_y, k_stride_z,
-            transform_pos_z,
-            mesh);
+// a rectangle of faces found by the binary greedy mesher, in the local axes of its face direction.
+struct _greedy_binary_quad {
+    uint16_t i0, j0, i1, j1;    // the rectangle covers [i0,i1) x [j0,j1) of its slice
+    uint16_t k;                 // the slice, counted from the far end of the grid for negative face directions.
+    uint8_t  color_index;
+};
+
+// a growable array of quads in memory from the meshify context.
+struct _greedy_binary_quad_array {
+    const ogt_voxel_meshify_context* ctx;
+    _greedy_binary_quad* data;
+    uint32_t             count;
+    uint32_t             capacity;
+    bool push_back(const _greedy_binary_quad& quad) {
+        if (count == capacity) {
+            uint32_t new_capacity = capacity ? (capacity * 3) >> 1 : 1024;   // grow by 50% each time, otherwise start at 1024 quads.
+            _greedy_binary_quad* new_data = (_greedy_binary_quad*)_voxel_meshify_malloc(ctx, sizeof(_greedy_binary_quad) * new_capacity);
+            if (!new_data)
+                return false;
+            if (count)
+                memcpy(new_data, data, sizeof(_greedy_binary_quad) * count);
+            _voxel_meshify_free(ctx, data);
+            data     = new_data;
+            capacity = new_capacity;
+        }
+        data[count++] = quad;
+        return true;
     }
-    // do the -Z pass
-    {
-        ogt_mesh_transform transform_neg_z = _make_transform(
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, -1.0f, 0.0f,
-            0.0f, 0.0f,(float)size_z, 0.0f);
+};
 
-        _greedy_meshify_voxels_in_face_direction(
-            voxels + (size_z-1) * k_stride_z, 
-            palette,
-            size_x, size_y, size_z,
-            k_stride_x, k_stride_y, -k_stride_z,
-            transform_neg_z,
-            mesh);
+// finds the greedy quads of one face direction, given its slices of color indices laid out contiguously in i -> j -> k order,
+// and the masks of which of those voxels are solid. Uses the same search order and rules as _greedy_meshify_voxels_in_face_direction,
+// so it finds exactly the same quads, but the faces that need meshing are tracked as bitmasks per row. Only the slices from k0_begin
+// up to but excluding k0_end in the order that the face direction visits them are meshed. remaining needs room for the row masks of one slice.
+static bool _greedy_binary_find_quads_in_face_direction(
+    const uint8_t* slices, const uint64_t* solid_masks, uint32_t size_i, uint32_t size_j, uint32_t size_k, bool is_negative,
+    uint32_t k0_begin, uint32_t k0_end, uint64_t* remaining, _greedy_binary_quad_array& quads)
+{
+    const uint32_t words_per_row   = (size_i + 63) / 64;
+    const uint32_t words_per_slice = words_per_row * size_j;
+    const uint32_t slice_size      = size_i * size_j;
+
+    for (uint32_t k0 = k0_begin; k0 < k0_end; k0++) {
+        const uint32_t slice = is_negative ? size_k - 1 - k0 : k0;
+        const uint8_t* slice_colors = &slices[(size_t)slice * slice_size];
+
+        // a face is needed wherever the voxel is solid, and the voxel in the next slice (in the face direction) isn't.
+        const uint64_t* solid = &solid_masks[(size_t)slice * words_per_slice];
+        if (k0 + 1 < size_k) {
+            const uint64_t* next_solid = &solid_masks[(size_t)(is_negative ? slice - 1 : slice + 1) * words_per_slice];
+            for (uint32_t w = 0; w < words_per_slice; w++)
+                remaining[w] = solid[w] & ~next_solid[w];
+        }
+        else {
+            memcpy(remaining, solid, sizeof(uint64_t) * words_per_slice);
+        }
+
+        for (uint32_t j0 = 0; j0 < size_j; j0++) {
+            uint64_t* row_remaining = &remaining[j0 * words_per_row];
+            const uint8_t* row_colors = &slice_colors[j0 * size_i];
+            for (uint32_t w = 0; w < words_per_row; w++) {
+                // the lowest face still to be meshed in this row is always where the next quad starts.
+                while (row_remaining[w]) {
+                    const uint32_t i0 = w * 64 + _mesh_lowest_bit_index(row_remaining[w]);
+                    const uint8_t color_index = row_colors[i0];
+
+                    // extend i1 over the run of faces still to be meshed, and then over those with the same color.
+                    uint32_t i1 = i0 + 1;
+                    while (i1 < size_i) {
+                        uint64_t bits = row_remaining[i1 >> 6] >> (i1 & 63);
+                        uint32_t run_end = (~bits) ? i1 + _mesh_lowest_bit_index(~bits) : i1 + 64 - (i1 & 63);
+                        if (run_end == i1)
+                            break;
+                        i1 = _mesh_find_color_mismatch(row_colors, i1, run_end, color_index);
+                        if (i1 < run_end)
+                            break;
+                    }
+
+                    // extend j1 while every face in [i0,i1) of the next row still needs meshing and has the same color.
+                    uint32_t j1 = j0 + 1;
+                    for (; j1 < size_j; j1++) {
+                        const uint64_t* next_row_remaining = &remaining[j1 * words_per_row];
+                        bool all_remaining = true;
+                        for (uint32_t word = i0 >> 6; word <= ((i1 - 1) >> 6) && all_remaining; word++) {
+                            uint64_t range = _mesh_word_bit_range(word * 64, i0, i1);
+                            all_remaining = (next_row_remaining[word] & range) == range;
+                        }
+                        if (!all_remaining || _mesh_find_color_mismatch(&slice_colors[j1 * size_i], i0, i1, color_index) != i1)
+                            break;
+                    }
+
+                    // the faces covered by the quad no longer need meshing.
+                    for (uint32_t b = j0; b < j1; b++) {
+                        for (uint32_t word = i0 >> 6; word <= ((i1 - 1) >> 6); word++)
+                            remaining[b * words_per_row + word] &= ~_mesh_word_bit_range(word * 64, i0, i1);
+                    }
+
+                    _greedy_binary_quad quad;
+                    quad.i0 = (uint16_t)i0;
+                    quad.j0 = (uint16_t)j0;
+                    quad.i1 = (uint16_t)i1;
+                    quad.j1 = (uint16_t)j1;
+                    quad.k  = (uint16_t)k0;
+                    quad.color_index = color_index;
+                    if (!quads.push_back(quad))
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// transposes an 8x8 block of bytes held as 8 rows of 8 bytes, by swapping ever larger sub-blocks across the diagonal.
+static inline void _mesh_transpose_8x8_bytes(uint64_t* rows) {
+    for (uint32_t i = 0; i < 8; i += 2) {
+        uint64_t swap = ((rows[i] >> 8) ^ rows[i + 1]) & 0x00FF00FF00FF00FFull;
+        rows[i + 1] ^= swap;
+        rows[i]     ^= swap << 8;
+    }
+    for (uint32_t i = 0; i < 8; i += (i & 1) ? 3 : 1) {
+        uint64_t swap = ((rows[i] >> 16) ^ rows[i + 2]) & 0x0000FFFF0000FFFFull;
+        rows[i + 2] ^= swap;
+        rows[i]     ^= swap << 16;
+    }
+    for (uint32_t i = 0; i < 4; i++) {
+        uint64_t swap = ((rows[i] >> 32) ^ rows[i + 4]) & 0x00000000FFFFFFFFull;
+        rows[i + 4] ^= swap;
+        rows[i]     ^= swap << 32;
+    }
+}
+
+// writes dst[c * dst_stride + r] = src[r * src_stride + c] for a rows x cols block of bytes. Works through 8x8 tiles
+// so that the reads and the writes of each tile only touch a handful of cache lines.
+static void _mesh_transpose_bytes(const uint8_t* src, uint32_t src_stride, uint32_t rows, uint32_t cols, uint8_t* dst, uint32_t dst_stride) {
+    for (uint32_t r0 = 0; r0 < rows; r0 += 8) {
+        const uint32_t r_end = rows - r0 < 8 ? rows : r0 + 8;
+        for (uint32_t c0 = 0; c0 < cols; c0 += 8) {
+            const uint32_t c_end = cols - c0 < 8 ? cols : c0 + 8;
+            if (r_end - r0 == 8 && c_end - c0 == 8) {
+                uint64_t tile[8];
+                for (uint32_t r = 0; r < 8; r++)
+                    memcpy(&tile[r], &src[(size_t)(r0 + r) * src_stride + c0], 8);
+                _mesh_transpose_8x8_bytes(tile);
+                for (uint32_t c = 0; c < 8; c++)
+                    memcpy(&dst[(size_t)(c0 + c) * dst_stride + r0], &tile[c], 8);
+                continue;
+            }
+            for (uint32_t c = c0; c < c_end; c++) {
+                uint8_t* dst_row = &dst[(size_t)c * dst_stride];
+                for (uint32_t r = r0; r < r_end; r++)
+                    dst_row[r] = src[(size_t)r * src_stride + c];
+            }
+        }
+    }
+}
+
+// lays out the voxels as contiguous slices along the k axis of a face direction, in i -> j -> k order. Only slices from k_begin up to
+// but excluding k_end are written.
+static void _greedy_binary_gather_slices(const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const _mesh_face_axes& axes,
+    uint32_t k_begin, uint32_t k_end, uint8_t* slices)
+{
+    if (axes.axis_k == 0) {
+        // slices along x are y -> z. Transpose the columns of each z plane of y -> x rows into them.
+        for (uint32_t z = 0; z < size_z; z++)
+            _mesh_transpose_bytes(&voxels[(size_t)z * size_x * size_y + k_begin], size_x, size_y, k_end - k_begin, &slices[(size_t)k_begin * size_y * size_z + z * size_y], size_y * size_z);
+    }
+    else {
+        // slices along y are z -> x. Transpose each y row of x -> z voxels into them.
+        assert(axes.axis_k == 1);
+        for (uint32_t y = k_begin; y < k_end; y++)
+            _mesh_transpose_bytes(&voxels[(size_t)y * size_x], size_x * size_y, size_z, size_x, &slices[(size_t)y * size_x * size_z], size_z);
+    }
+}
+
+// builds the solid masks of the slices from k_begin up to but excluding k_end, laid out like the slices themselves.
+static void _greedy_binary_build_solid_masks(const uint8_t* slices, const _mesh_face_axes& axes, uint32_t k_begin, uint32_t k_end, uint64_t* solid_masks) {
+    const uint32_t words_per_row = (axes.size_i + 63) / 64;
+    for (uint32_t row = k_begin * axes.size_j; row < k_end * axes.size_j; row++)
+        _mesh_build_solid_row_mask(&slices[(size_t)row * axes.size_i], axes.size_i, &solid_masks[(size_t)row * words_per_row]);
+}
+
+// writes the quads found for a face direction into the mesh.
+static void _greedy_binary_write_quads(_mesh_writer& out, const _mesh_face_axes& axes, const _greedy_binary_quad* quads, uint32_t quad_count) {
+    uint32_t face = _mesh_face_from_normal(_transform_vector(axes.transform, _make_vec3(0.0f, 0.0f, 1.0f)));
+    bool is_parity_flipped = _is_transform_parity_flipped(axes.transform);
+    for (uint32_t quad_index = 0; quad_index < quad_count; quad_index++) {
+        const _greedy_binary_quad& quad = quads[quad_index];
+        _greedy_write_quad(out, axes.transform, face, is_parity_flipped,
+            (float)quad.i0, (float)quad.i1, (float)quad.j0, (float)quad.j1, (float)(quad.k + 1), quad.color_index);
     }
+}
 
-    assert( mesh->vertex_count <= max_vertex_count);
-    assert( mesh->index_count <= max_index_count);	
+// the serial binary greedy mesher, writing the mesh through out.
+static void* _mesh_from_paletted_voxels_greedy_binary(
+    const ogt_voxel_meshify_context* ctx,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, _mesh_writer& out)
+{
+    assert(size_x <= 65535 && size_y <= 65535 && size_z <= 65535);
+    _greedy_binary_quad_array quads;
+    quads.ctx      = ctx;
+    quads.data     = NULL;
+    quads.count    = 0;
+    quads.capacity = 0;
+    uint32_t face_first_quad[7] = { 0, 0, 0, 0, 0, 0, 0 };
+
+    // scratch for the transposed slices of the x and y face directions, the solid masks of all slices along one axis, and
+    // the masks of faces that remain to be meshed in one slice.
+    const size_t num_voxels = (size_t)size_x * size_y * size_z;
+    size_t max_words_per_slice = 0, max_words_per_axis = 0;
+    for (uint32_t face_index = 0; face_index < 6; face_index += 2) {
+        _mesh_face_axes axes = _get_mesh_face_axes(face_index, size_x, size_y, size_z);
+        size_t words_per_slice = (size_t)((axes.size_i + 63) / 64) * axes.size_j;
+        if (words_per_slice > max_words_per_slice)
+            max_words_per_slice = words_per_slice;
+        if (words_per_slice * axes.size_k > max_words_per_axis)
+            max_words_per_axis = words_per_slice * axes.size_k;
+    }
+    uint8_t*  slices      = (uint8_t*)_voxel_meshify_malloc(ctx, num_voxels);
+    uint64_t* solid_masks = (uint64_t*)_voxel_meshify_malloc(ctx, sizeof(uint64_t) * (max_words_per_axis + max_words_per_slice));
+    uint64_t* remaining   = solid_masks + max_words_per_axis;
+    bool succeeded = num_voxels == 0 || (slices && solid_masks);
+
+    // find the quads of the +Y, -Y, +X, -X, +Z, -Z face directions in that order, just like the greedy meshifier.
+    for (uint32_t face_index = 0; face_index < 6 && succeeded && num_voxels; face_index++) {
+        _mesh_face_axes axes = _get_mesh_face_axes(face_index, size_x, size_y, size_z);
+        // z slices are already contiguous, and each other axis is gathered once for both of its face directions.
+        const uint8_t* face_slices = (axes.axis_k == 2) ? voxels : slices;
+        if (!axes.is_negative) {
+            if (axes.axis_k != 2)
+                _greedy_binary_gather_slices(voxels, size_x, size_y, size_z, axes, 0, axes.size_k, slices);
+            // both face directions of an axis share the solid masks of its slices too.
+            _greedy_binary_build_solid_masks(face_slices, axes, 0, axes.size_k, solid_masks);
+        }
+        succeeded = _greedy_binary_find_quads_in_face_direction(face_slices, solid_masks, axes.size_i, axes.size_j, axes.size_k, axes.is_negative,
+            0, axes.size_k, remaining, quads);
+        face_first_quad[face_index + 1] = quads.count;
+    }
+    _voxel_meshify_free(ctx, solid_masks);
+    _voxel_meshify_free(ctx, slices);
+
+    void* mesh = succeeded ? _mesh_writer_alloc(ctx, out, quads.count * 4, quads.count * 6) : NULL;
+    if (mesh) {
+        for (uint32_t face_index = 0; face_index < 6; face_index++) {
+            _mesh_face_axes axes = _get_mesh_face_axes(face_index, size_x, size_y, size_z);
+            _greedy_binary_write_quads(out, axes, &quads.data[face_first_quad[face_index]], face_first_quad[face_index + 1] - face_first_quad[face_index]);
+        }
+        _mesh_writer_finish(mesh, out);
+    }
+    _voxel_meshify_free(ctx, quads.data);
     return mesh;
 }
 
+ogt_mesh* ogt_mesh_from_paletted_voxels_greedy_binary(
+    const ogt_voxel_meshify_context* ctx,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette)
+{
+    if (ctx->job_submit_func)
+        return ogt_mesh_from_paletted_voxels_greedy_parallel(ctx, voxels, size_x, size_y, size_z, palette, NULL, NULL, NULL);
+
+    _mesh_writer out = _make_mesh_writer(palette);
+    return (ogt_mesh*)_mesh_from_paletted_voxels_greedy_binary(ctx, voxels, size_x, size_y, size_z, out);
+}
+
+// shared state of the tasks of ogt_mesh_from_paletted_voxels_greedy_parallel.
+struct _greedy_parallel_task_data {
+    const ogt_voxel_meshify_context* ctx;
+    const uint8_t*             voxels;
+    uint32_t                   size_x, size_y, size_z;
+    const uint8_t*             slices[3];           // slices along each of the x, y, z axes. z slices are the voxels themselves.
+    uint64_t*                  solid_masks[3];      // solid masks of the slices along each of the x, y, z axes.
+    const _mesh_slice_range*   ranges;
+    _greedy_binary_quad_array* range_quads;         // the quads found in each range
+    bool*                      range_failed;        // whether finding the quads of each range ran out of memory
+    uint32_t*                  range_first_quad;    // where the quads of each range start in the mesh
+    const _mesh_writer*        out;
+};
+
+// gathers the slices of a range of a positive face direction, and builds their solid masks for both face directions of the axis.
+static void _greedy_parallel_gather_task(void* task_data, uint32_t task_index) {
+    _greedy_parallel_task_data* data = (_greedy_parallel_task_data*)task_data;
+    const _mesh_slice_range& range = data->ranges[task_index];
+    _mesh_face_axes axes = _get_mesh_face_axes(range.face_index, data->size_x, data->size_y, data->size_z);
+    if (axes.axis_k != 2)
+        _greedy_binary_gather_slices(data->voxels, data->size_x, data->size_y, data->size_z, axes, range.k_begin, range.k_end, (uint8_t*)data->slices[axes.axis_k]);
+    _greedy_binary_build_solid_masks(data->slices[axes.axis_k], axes, range.k_begin, range.k_end, data->solid_masks[axes.axis_k]);
+}
+
+// finds the quads of a range of a face direction.
+static void _greedy_parallel_find_quads_task(void* task_data, uint32_t task_index) {
+    _greedy_parallel_task_data* data = (_greedy_parallel_task_data*)task_data;
+    const _mesh_slice_range& range = data->ranges[task_index];
+    _mesh_face_axes axes = _get_mesh_face_axes(range.face_index, data->size_x, data->size_y, data->size_z);
+    uint64_t* remaining = (uint64_t*)_voxel_meshify_malloc(data->ctx, sizeof(uint64_t) * ((axes.size_i + 63) / 64) * axes.size_j);
+    data->range_failed[task_index] = !remaining ||
+        !_greedy_binary_find_quads_in_face_direction(data->slices[axes.axis_k], data->solid_masks[axes.axis_k], axes.size_i, axes.size_j, axes.size_k, axes.is_negative,
+            range.k_begin, range.k_end, remaining, data->range_quads[task_index]);
+    _voxel_meshify_free(data->ctx, remaining);
+}
+
+// writes the quads of a range into their place in the mesh.
+static void _greedy_parallel_write_quads_task(void* task_data, uint32_t task_index) {
+    _greedy_parallel_task_data* data = (_greedy_parallel_task_data*)task_data;
+    _mesh_face_axes axes = _get_mesh_face_axes(data->ranges[task_index].face_index, data->size_x, data->size_y, data->size_z);
+    _mesh_writer range_out = *data->out;
+    range_out.vertex_count = data->range_first_quad[task_index] * 4;
+    range_out.index_count  = data->range_first_quad[task_index] * 6;
+    _greedy_binary_write_quads(range_out, axes, data->range_quads[task_index].data, data->range_quads[task_index].count);
+}
+
+// the parallel greedy mesher, writing the mesh through out.
+static void* _mesh_from_paletted_voxels_greedy_parallel(
+    const ogt_voxel_meshify_context* ctx, const _mesh_job_system& jobs,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, _mesh_writer& out)
+{
+    assert(size_x <= 65535 && size_y <= 65535 && size_z <= 65535);
+
+    // the gather tasks cover the slices along each axis once, and the other tasks cover every face direction.
+    const uint32_t gather_range_count = _mesh_split_slice_ranges(size_x, size_y, size_z, 2, NULL);
+    const uint32_t range_count        = _mesh_split_slice_ranges(size_x, size_y, size_z, 1, NULL);
+    _mesh_slice_range* gather_ranges = (_mesh_slice_range*)_voxel_meshify_malloc(ctx, sizeof(_mesh_slice_range) * gather_range_count);
+    _mesh_slice_range* ranges        = (_mesh_slice_range*)_voxel_meshify_malloc(ctx, sizeof(_mesh_slice_range) * range_count);
+    _greedy_binary_quad_array* range_quads = (_greedy_binary_quad_array*)_voxel_meshify_calloc(ctx, sizeof(_greedy_binary_quad_array) * range_count);
+    bool*     range_failed     = (bool*)_voxel_meshify_calloc(ctx, sizeof(bool) * range_count);
+    uint32_t* range_first_quad = (uint32_t*)_voxel_meshify_malloc(ctx, sizeof(uint32_t) * (range_count + 1));
+
+    // scratch for the slices along x and y, which are both needed at once, and the solid masks of the slices along every axis.
+    const size_t num_voxels = (size_t)size_x * size_y * size_z;
+    size_t axis_mask_offsets[4] = { 0, 0, 0, 0 };
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        _mesh_face_axes axes = _get_mesh_face_axes(axis == 0 ? 2 : axis == 1 ? 0 : 4, size_x, size_y, size_z);
+        axis_mask_offsets[axis + 1] = axis_mask_offsets[axis] + (size_t)((axes.size_i + 63) / 64) * axes.size_j * axes.size_k;
+    }
+    uint8_t*  slices      = (uint8_t*)_voxel_meshify_malloc(ctx, num_voxels * 2);
+    uint64_t* solid_masks = (uint64_t*)_voxel_meshify_malloc(ctx, sizeof(uint64_t) * axis_mask_offsets[3]);
+
+    void* mesh = NULL;
+    bool succeeded = (range_count == 0) ||
+        (gather_ranges && ranges && range_quads && range_failed && range_first_quad && slices && solid_masks);
+    _greedy_parallel_task_data task_data;
+    uint32_t quad_count = 0;
+    if (succeeded && range_count) {
+        _mesh_split_slice_ranges(size_x, size_y, size_z, 2, gather_ranges);
+        _mesh_split_slice_ranges(size_x, size_y, size_z, 1, ranges);
+        for (uint32_t range_index = 0; range_index < range_count; range_index++)
+            range_quads[range_index].ctx = ctx;
+
+        task_data.ctx              = ctx;
+        task_data.voxels           = voxels;
+        task_data.size_x           = size_x;
+        task_data.size_y           = size_y;
+        task_data.size_z           = size_z;
+        task_data.slices[0]        = slices;
+        task_data.slices[1]        = slices + num_voxels;
+        task_data.slices[2]        = voxels;
+        task_data.solid_masks[0]   = solid_masks + axis_mask_offsets[0];
+        task_data.solid_masks[1]   = solid_masks + axis_mask_offsets[1];
+        task_data.solid_masks[2]   = solid_masks + axis_mask_offsets[2];
+        task_data.range_quads      = range_quads;
+        task_data.range_failed     = range_failed;
+        task_data.range_first_quad = range_first_quad;
+        task_data.out              = &out;
+
+        // the quads of a slice depend on the next slice too, so all slices must be gathered before any quads are found.
+        task_data.ranges = gather_ranges;
+        _mesh_run_tasks(jobs, _greedy_parallel_gather_task, &task_data, gather_range_count);
+        task_data.ranges = ranges;
+        _mesh_run_tasks(jobs, _greedy_parallel_find_quads_task, &task_data, range_count);
+
+        // the ranges are in the order that the serial mesher visits them, so laying out their quads in range order gives the same mesh.
+        range_first_quad[0] = 0;
+        for (uint32_t range_index = 0; range_index < range_count; range_index++) {
+            succeeded = succeeded && !range_failed[range_index];
+            range_first_quad[range_index + 1] = range_first_quad[range_index] + range_quads[range_index].count;
+        }
+        quad_count = range_first_quad[range_count];
+    }
+    if (succeeded)
+        mesh = _mesh_writer_alloc(ctx, out, quad_count * 4, quad_count * 6);
+    if (mesh) {
+        if (range_count)
+            _mesh_run_tasks(jobs, _greedy_parallel_write_quads_task, &task_data, range_count);
+        out.vertex_count = quad_count * 4;
+        out.index_count  = quad_count * 6;
+        _mesh_writer_finish(mesh, out);
+    }
+
+    for (uint32_t range_index = 0; range_quads && range_index < range_count; range_index++)
+        _voxel_meshify_free(ctx, range_quads[range_index].data);
+    _voxel_meshify_free(ctx, solid_masks);
+    _voxel_meshify_free(ctx, slices);
+    _voxel_meshify_free(ctx, range_first_quad);
+    _voxel_meshify_free(ctx, range_failed);
+    _voxel_meshify_free(ctx, range_quads);
+    _voxel_meshify_free(ctx, ranges);
+    _voxel_meshify_free(ctx, gather_ranges);
+    return mesh;
+}
+
+ogt_mesh* ogt_mesh_from_paletted_voxels_greedy_parallel(
+    const ogt_voxel_meshify_context* ctx,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette,
+    ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* job_user_data)
+{
+    _mesh_job_system jobs = _make_job_system(ctx, submit_func, wait_func, job_user_data);
+    _mesh_writer out = _make_mesh_writer(palette);
+    return (ogt_mesh*)_mesh_from_paletted_voxels_greedy_parallel(ctx, jobs, voxels, size_x, size_y, size_z, out);
+}
+
 struct ogt_mesh_vec2i {
     int32_t x, y;
 };
@@ -1551,11 +2521,11 @@ int32_t _construct_polygon_for_slice(ogt_mesh_vec2i* verts, uint32_t max_verts,
 
 void _polygon_meshify_voxels_in_face_direction(
     const uint8_t* voxels,
-    const ogt_mesh_rgba* palette,
     int32_t size_x, int32_t size_y, int32_t size_z,                // how many voxels in each of X,Y,Z dimensions
     int32_t k_stride_x, int32_t k_stride_y, int32_t k_stride_z,    // the memory stride for each of those X,Y,Z dimensions within the voxel data.
     const ogt_mesh_transform& transform,                           // transform to convert from X,Y,Z to "objectSpace"
-    ogt_mesh* mesh)
+    int32_t k_begin, int32_t k_end,                                // the range of Z slices to mesh
+    _mesh_writer& out)
 {
     // enable aggressive voxel optimization for now.
     uint32_t max_voxels_per_slice = size_x * size_y;
@@ -1569,9 +2539,9 @@ void _polygon_meshify_voxels_in_face_direction(
     const ogt_mesh_vec3* fwd  = _make_vec3_ptr(&transform.m20);
     bool is_parity_flipped    = _dot3(*fwd, _cross3(*side, *up)) < 0.0f;
 
-    ogt_mesh_vec3 normal = _transform_vector(transform, _make_vec3(0.0f, 0.0f, 1.0f));
+    uint32_t face = _mesh_face_from_normal(_transform_vector(transform, _make_vec3(0.0f, 0.0f, 1.0f)));
 
-    for ( int32_t k = 0; k < (int32_t)size_z; k++ ) {
+    for ( int32_t k = k_begin; k < k_end; k++ ) {
         bool is_last_slice = (k == (size_z-1)) ? true : false;
 
         // clear this slice
@@ -1629,40 +2599,40 @@ void _polygon_meshify_voxels_in_face_direction(
                 ogt_mesh_vec2i verts[MAX_VERTS];
                 uint32_t vert_count = _construct_polygon_for_slice(verts, MAX_VERTS, i, j, size_x, size_y, slice_colors, voxel_polygonized);
                 
-                const ogt_mesh_rgba& color = palette[color_index];
-
                 // generate the verts in the output mesh
-                uint32_t base_vertex_index = mesh->vertex_count;
+                uint32_t base_vertex_index = out.vertex_count;
                 for (uint32_t i = 0; i < vert_count; i++) {
-                    mesh->vertices[mesh->vertex_count++] = _mesh_make_vertex(_transform_point(transform, _make_vec3((float)verts[i].x,   (float)verts[i].y,   (float)(k+1))), normal, color);
+                    ogt_mesh_vec3 pos = _transform_point(transform, _make_vec3((float)verts[i].x,   (float)verts[i].y,   (float)(k+1)));
+                    out.write_vertices(out.vertices, out.vertex_count++, &pos, 1, face, color_index, out.palette);
                 }
 
                 // generate the indices in the output mesh.
-                uint32_t tessellated_index_count = _tessellate_polygon(&mesh->indices[mesh->index_count], verts, vert_count);
+                uint32_t* indices = &out.indices[out.index_count];
+                uint32_t tessellated_index_count = _tessellate_polygon(indices, verts, vert_count);
 
                 // flip the winding of tessellated triangles to account for an inversion in the transform.
                 if (is_parity_flipped) {
                     for (uint32_t i = 0; i < tessellated_index_count; i += 3) {
-                        uint32_t i0 = mesh->indices[mesh->index_count + i + 0];
-                        uint32_t i1 = mesh->indices[mesh->index_count + i + 1];
-                        uint32_t i2 = mesh->indices[mesh->index_count + i + 2];
-                        mesh->indices[mesh->index_count + i + 0] = base_vertex_index + i2;
-                        mesh->indices[mesh->index_count + i + 1] = base_vertex_index + i1;
-                        mesh->indices[mesh->index_count + i + 2] = base_vertex_index + i0;
+                        uint32_t i0 = indices[i + 0];
+                        uint32_t i1 = indices[i + 1];
+                        uint32_t i2 = indices[i + 2];
+                        indices[i + 0] = base_vertex_index + i2;
+                        indices[i + 1] = base_vertex_index + i1;
+                        indices[i + 2] = base_vertex_index + i0;
                     }
                 }
                 else {
                     for (uint32_t i = 0; i < tessellated_index_count; i += 3) {
-                        uint32_t i0 = mesh->indices[mesh->index_count + i + 0];
-                        uint32_t i1 = mesh->indices[mesh->index_count + i + 1];
-                        uint32_t i2 = mesh->indices[mesh->index_count + i + 2];
-                        mesh->indices[mesh->index_count + i + 0] = base_vertex_index + i0;
-                        mesh->indices[mesh->index_count + i + 1] = base_vertex_index + i1;
-                        mesh->indices[mesh->index_count + i + 2] = base_vertex_index + i2;
+                        uint32_t i0 = indices[i + 0];
+                        uint32_t i1 = indices[i + 1];
+                        uint32_t i2 = indices[i + 2];
+                        indices[i + 0] = base_vertex_index + i0;
+                        indices[i + 1] = base_vertex_index + i1;
+                        indices[i + 2] = base_vertex_index + i2;
                     }
                 }
 
-                mesh->index_count += tessellated_index_count;
+                out.index_count += tessellated_index_count;
             }
         }
     }
@@ -1677,128 +2647,392 @@ void _polygon_meshify_voxels_in_face_direction(
 //        while (can expand polygon)
 //          choose an edge and expand it out as far as possible, tessellating surrounding edges if neccessary, marking newly expanded cells as polygonized
 //        triangulate the output polygon.
-ogt_mesh* ogt_mesh_from_paletted_voxels_polygon(
-    const ogt_voxel_meshify_context* ctx, 
-    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette) {
+static void* _mesh_from_paletted_voxels_polygon(
+    const ogt_voxel_meshify_context* ctx,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, _mesh_writer& out) {
     uint32_t max_face_count   = _count_voxel_sized_faces( voxels, size_x, size_y, size_z );
     uint32_t max_vertex_count = max_face_count * 4;
     uint32_t max_index_count  = max_face_count * 6;
 
-    uint32_t mesh_size = sizeof(ogt_mesh) + (max_vertex_count * sizeof(ogt_mesh_vertex)) + (max_index_count * sizeof(uint32_t));
-    ogt_mesh* mesh = (ogt_mesh*)_voxel_meshify_malloc(ctx, mesh_size);
+    void* mesh = _mesh_writer_alloc(ctx, out, max_vertex_count, max_index_count);
     if (!mesh)
         return NULL;
-
-    mesh->vertices = (ogt_mesh_vertex*)&mesh[1];
-    mesh->indices  = (uint32_t*)&mesh->vertices[max_vertex_count];
-    mesh->vertex_count = 0;
-    mesh->index_count  = 0;
     
-    const int32_t k_stride_x = 1;
-    const int32_t k_stride_y = size_x;
-    const int32_t k_stride_z = size_x * size_y;
-    
-    // do the +y PASS
-    {
-        ogt_mesh_transform transform_pos_y = _make_transform(
-            0.0f, 0.0f, 1.0f, 0.0f,
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 0.0f, 0.0f);
-
+    // do the +Y, -Y, +X, -X, +Z, -Z passes in that order.
+    for (uint32_t face_index = 0; face_index < 6; face_index++) {
+        _mesh_face_axes axes = _get_mesh_face_axes(face_index, size_x, size_y, size_z);
         _polygon_meshify_voxels_in_face_direction(
-            voxels, palette,
-            size_z, size_x, size_y,
-            k_stride_z, k_stride_x, k_stride_y,
-            transform_pos_y,
-            mesh);
+            voxels + axes.origin,
+            axes.size_i, axes.size_j, axes.size_k,
+            axes.stride_i, axes.stride_j, axes.stride_k,
+            axes.transform,
+            0, axes.size_k,
+            out);
     }
-    
-    // do the -y PASS
-    {
-        ogt_mesh_transform transform_neg_y = _make_transform(
-            0.0f, 0.0f, 1.0f, 0.0f,
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f,-1.0f, 0.0f, 0.0f,
-            0.0f, (float)(size_y), 0.0f, 0.0f);
 
-        _polygon_meshify_voxels_in_face_direction(
-            voxels + (size_y - 1) * k_stride_y, 
-            palette,
-            size_z, size_x, size_y,
-            k_stride_z, k_stride_x,-k_stride_y,
-            transform_neg_y,
-            mesh);
-    }
-    // do the +X pass
-    {
-        ogt_mesh_transform transform_pos_x = _make_transform(
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 0.0f, 0.0f);
+    assert( out.vertex_count <= max_vertex_count);
+    assert( out.index_count <= max_index_count);
 
-        _polygon_meshify_voxels_in_face_direction(
-            voxels, palette,
-            size_y, size_z, size_x,
-            k_stride_y, k_stride_z, k_stride_x,
-            transform_pos_x,
-            mesh);
+    return _mesh_writer_finish(mesh, out);
+}
+
+ogt_mesh* ogt_mesh_from_paletted_voxels_polygon(
+    const ogt_voxel_meshify_context* ctx, 
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette) {
+    // the parallel polygon mesher produces the same mesh, so use it whenever the context has a job system.
+    if (ctx->job_submit_func)
+        return ogt_mesh_from_paletted_voxels_polygon_parallel(ctx, voxels, size_x, size_y, size_z, palette, NULL, NULL, NULL);
+
+    _mesh_writer out = _make_mesh_writer(palette);
+    return (ogt_mesh*)_mesh_from_paletted_voxels_polygon(ctx, voxels, size_x, size_y, size_z, out);
+}
+
+// counts the voxel sized faces in a range of slices of a face direction. Like _count_voxel_sized_faces, this bounds the size of any mesh of them.
+static uint32_t _count_voxel_sized_faces_in_slices(const uint8_t* voxels, const _mesh_face_axes& axes, int32_t k_begin, int32_t k_end) {
+    uint32_t face_count = 0;
+    for (int32_t k = k_begin; k < k_end; k++) {
+        const uint8_t* slice_voxels = voxels + axes.origin + k * axes.stride_k;
+        bool is_last_slice = (k == axes.size_k - 1);
+        for (int32_t j = 0; j < axes.size_j; j++) {
+            for (int32_t i = 0; i < axes.size_i; i++) {
+                int32_t index = i * axes.stride_i + j * axes.stride_j;
+                face_count += (slice_voxels[index] != 0 && (is_last_slice || slice_voxels[index + axes.stride_k] == 0)) ? 1 : 0;
+            }
+        }
     }
-    // do the -X pass
-    {
-        ogt_mesh_transform transform_neg_x = _make_transform(
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-           -1.0f, 0.0f, 0.0f, 0.0f,
-        (float)size_x, 0.0f, 0.0f, 0.0f);
+    return face_count;
+}
 
-        _polygon_meshify_voxels_in_face_direction(
-            voxels + (size_x - 1) * k_stride_x,
-            palette,
-            size_y, size_z, size_x,
-            k_stride_y, k_stride_z, -k_stride_x,
-            transform_neg_x,
-            mesh);
-    }
-    // do the +Z pass
-    {
-        ogt_mesh_transform transform_pos_z = _make_transform(
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-            0.0f, 0.0f, 0.0f, 0.0f);
+// shared state of the tasks of ogt_mesh_from_paletted_voxels_polygon_parallel.
+struct _polygon_parallel_task_data {
+    const ogt_voxel_meshify_context* ctx;
+    const uint8_t*           voxels;
+    uint32_t                 size_x, size_y, size_z;
+    const _mesh_slice_range* ranges;
+    void**                   range_meshes;          // the mesh of each range, or NULL if it ran out of memory
+    _mesh_writer*            range_outs;            // what was written to the mesh of each range
+    uint32_t*                range_first_vertex;    // where the vertices of each range start in the mesh
+    uint32_t*                range_first_index;     // where the indices of each range start in the mesh
+    const _mesh_writer*      out;
+};
 
-        _polygon_meshify_voxels_in_face_direction(
-            voxels, palette,
-            size_x, size_y, size_z,
-            k_stride_x, k_stride_y, k_stride_z,
-            transform_pos_z,
-            mesh);
+// meshes a range of a face direction into its own mesh.
+static void _polygon_parallel_mesh_task(void* task_data, uint32_t task_index) {
+    _polygon_parallel_task_data* data = (_polygon_parallel_task_data*)task_data;
+    const _mesh_slice_range& range = data->ranges[task_index];
+    _mesh_face_axes axes = _get_mesh_face_axes(range.face_index, data->size_x, data->size_y, data->size_z);
+    uint32_t max_face_count   = _count_voxel_sized_faces_in_slices(data->voxels, axes, range.k_begin, range.k_end);
+    uint32_t max_vertex_count = max_face_count * 4;
+    uint32_t max_index_count  = max_face_count * 6;
+
+    _mesh_writer& range_out = data->range_outs[task_index];
+    range_out = *data->out;
+    void* range_mesh = _mesh_writer_alloc(data->ctx, range_out, max_vertex_count, max_index_count);
+    data->range_meshes[task_index] = range_mesh;
+    if (!range_mesh)
+        return;
+
+    _polygon_meshify_voxels_in_face_direction(
+        data->voxels + axes.origin,
+        axes.size_i, axes.size_j, axes.size_k,
+        axes.stride_i, axes.stride_j, axes.stride_k,
+        axes.transform,
+        range.k_begin, range.k_end,
+        range_out);
+
+    assert(range_out.vertex_count <= max_vertex_count);
+    assert(range_out.index_count <= max_index_count);
+}
+
+// copies the mesh of a range into its place in the mesh, offsetting its indices by where its vertices went.
+static void _polygon_parallel_copy_task(void* task_data, uint32_t task_index) {
+    _polygon_parallel_task_data* data = (_polygon_parallel_task_data*)task_data;
+    const _mesh_writer& range_out = data->range_outs[task_index];
+    const uint32_t first_vertex = data->range_first_vertex[task_index];
+    uint32_t* indices = &data->out->indices[data->range_first_index[task_index]];
+    memcpy((uint8_t*)data->out->vertices + (size_t)first_vertex * range_out.vertex_size, range_out.vertices, (size_t)range_out.vertex_size * range_out.vertex_count);
+    for (uint32_t i = 0; i < range_out.index_count; i++)
+        indices[i] = range_out.indices[i] + first_vertex;
+}
+
+// the parallel polygon mesher, writing the mesh through out.
+static void* _mesh_from_paletted_voxels_polygon_parallel(
+    const ogt_voxel_meshify_context* ctx, const _mesh_job_system& jobs,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, _mesh_writer& out)
+{
+    const uint32_t range_count = _mesh_split_slice_ranges(size_x, size_y, size_z, 1, NULL);
+    _mesh_slice_range* ranges = (_mesh_slice_range*)_voxel_meshify_malloc(ctx, sizeof(_mesh_slice_range) * range_count);
+    void**         range_meshes       = (void**)_voxel_meshify_calloc(ctx, sizeof(void*) * range_count);
+    _mesh_writer*  range_outs         = (_mesh_writer*)_voxel_meshify_malloc(ctx, sizeof(_mesh_writer) * range_count);
+    uint32_t*      range_first_vertex = (uint32_t*)_voxel_meshify_malloc(ctx, sizeof(uint32_t) * (range_count + 1));
+    uint32_t*      range_first_index  = (uint32_t*)_voxel_meshify_malloc(ctx, sizeof(uint32_t) * (range_count + 1));
+
+    void* mesh = NULL;
+    bool succeeded = (range_count == 0) || (ranges && range_meshes && range_outs && range_first_vertex && range_first_index);
+    _polygon_parallel_task_data task_data;
+    uint32_t vertex_count = 0;
+    uint32_t index_count  = 0;
+    if (succeeded && range_count) {
+        _mesh_split_slice_ranges(size_x, size_y, size_z, 1, ranges);
+
+        task_data.ctx                = ctx;
+        task_data.voxels             = voxels;
+        task_data.size_x             = size_x;
+        task_data.size_y             = size_y;
+        task_data.size_z             = size_z;
+        task_data.ranges             = ranges;
+        task_data.range_meshes       = range_meshes;
+        task_data.range_outs         = range_outs;
+        task_data.range_first_vertex = range_first_vertex;
+        task_data.range_first_index  = range_first_index;
+        task_data.out                = &out;
+        _mesh_run_tasks(jobs, _polygon_parallel_mesh_task, &task_data, range_count);
+
+        // the ranges are in the order that the serial mesher visits them, so concatenating their meshes in range order gives the same mesh.
+        range_first_vertex[0] = 0;
+        range_first_index[0]  = 0;
+        for (uint32_t range_index = 0; range_index < range_count; range_index++) {
+            bool has_mesh = range_meshes[range_index] != NULL;
+            succeeded = succeeded && has_mesh;
+            range_first_vertex[range_index + 1] = range_first_vertex[range_index] + (has_mesh ? range_outs[range_index].vertex_count : 0);
+            range_first_index[range_index + 1]  = range_first_index[range_index]  + (has_mesh ? range_outs[range_index].index_count : 0);
+        }
+        vertex_count = range_first_vertex[range_count];
+        index_count  = range_first_index[range_count];
+    }
+    if (succeeded)
+        mesh = _mesh_writer_alloc(ctx, out, vertex_count, index_count);
+    if (mesh) {
+        if (range_count)
+            _mesh_run_tasks(jobs, _polygon_parallel_copy_task, &task_data, range_count);
+        out.vertex_count = vertex_count;
+        out.index_count  = index_count;
+        _mesh_writer_finish(mesh, out);
     }
-    // do the -Z pass
-    {
-        ogt_mesh_transform transform_neg_z = _make_transform(
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, -1.0f, 0.0f,
-            0.0f, 0.0f,(float)size_z, 0.0f);
 
-        _polygon_meshify_voxels_in_face_direction(
-            voxels + (size_z-1) * k_stride_z, 
-            palette,
-            size_x, size_y, size_z,
-            k_stride_x, k_stride_y, -k_stride_z,
-            transform_neg_z,
-            mesh);
+    for (uint32_t range_index = 0; range_meshes && range_index < range_count; range_index++)
+        _voxel_meshify_free(ctx, range_meshes[range_index]);
+    _voxel_meshify_free(ctx, range_first_index);
+    _voxel_meshify_free(ctx, range_first_vertex);
+    _voxel_meshify_free(ctx, range_outs);
+    _voxel_meshify_free(ctx, range_meshes);
+    _voxel_meshify_free(ctx, ranges);
+    return mesh;
+}
+
+ogt_mesh* ogt_mesh_from_paletted_voxels_polygon_parallel(
+    const ogt_voxel_meshify_context* ctx,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette,
+    ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* job_user_data)
+{
+    _mesh_job_system jobs = _make_job_system(ctx, submit_func, wait_func, job_user_data);
+    _mesh_writer out = _make_mesh_writer(palette);
+    return (ogt_mesh*)_mesh_from_paletted_voxels_polygon_parallel(ctx, jobs, voxels, size_x, size_y, size_z, out);
+}
+
+
+// fetches model model_index of a batch of models.
+typedef void (*_mesh_batch_get_model_func)(const void* models, uint32_t model_index, ogt_mesh_voxel_model* out_model);
+
+static void _mesh_batch_get_array_model(const void* models, uint32_t model_index, ogt_mesh_voxel_model* out_model) {
+    *out_model = ((const ogt_mesh_voxel_model*)models)[model_index];
+}
+
+// the number of faces of a model, which is how much work meshing it is.
+struct _mesh_batch_model_cost {
+    uint32_t face_count;
+    uint32_t model_index;
+};
+
+// orders models by descending face count, and by ascending index if those are equal.
+static int _mesh_batch_compare_model_cost(const void* lhs, const void* rhs) {
+    const _mesh_batch_model_cost* a = (const _mesh_batch_model_cost*)lhs;
+    const _mesh_batch_model_cost* b = (const _mesh_batch_model_cost*)rhs;
+    if (a->face_count != b->face_count)
+        return a->face_count > b->face_count ? -1 : 1;
+    return a->model_index < b->model_index ? -1 : a->model_index > b->model_index ? 1 : 0;
+}
+
+// shared state of the tasks of the batch meshers.
+struct _mesh_batch_task_data {
+    const ogt_voxel_meshify_context* ctx;
+    const void*                models;
+    _mesh_batch_get_model_func get_model;
+    const ogt_mesh_rgba*       palette;
+    ogt_mesh_algorithm         algorithm;
+    _mesh_batch_model_cost*    model_costs;         // one per model, by model index while counting and then by descending cost.
+    const uint32_t*            task_first_cost;     // each meshing task meshes the models of model_costs[task_first_cost[task]] up to the next task's.
+    ogt_mesh**                 out_meshes;
+};
+
+// counts the faces of a model.
+static void _mesh_batch_count_task(void* task_data, uint32_t task_index) {
+    _mesh_batch_task_data* data = (_mesh_batch_task_data*)task_data;
+    ogt_mesh_voxel_model model;
+    data->get_model(data->models, task_index, &model);
+    data->model_costs[task_index].face_count  = model.voxels ? _count_voxel_sized_faces(model.voxels, model.size_x, model.size_y, model.size_z) : 0;
+    data->model_costs[task_index].model_index = task_index;
+}
+
+// meshes a model with the serial version of the algorithm.
+static ogt_mesh* _mesh_batch_mesh_model(const ogt_voxel_meshify_context* ctx, const ogt_mesh_voxel_model& model, const ogt_mesh_rgba* palette, ogt_mesh_algorithm algorithm) {
+    if (!model.voxels)
+        return NULL;
+    switch (algorithm) {
+        case ogt_mesh_algorithm_simple:  return ogt_mesh_from_paletted_voxels_simple(ctx, model.voxels, model.size_x, model.size_y, model.size_z, palette);
+        case ogt_mesh_algorithm_greedy:  return ogt_mesh_from_paletted_voxels_greedy_binary(ctx, model.voxels, model.size_x, model.size_y, model.size_z, palette);
+        case ogt_mesh_algorithm_polygon: return ogt_mesh_from_paletted_voxels_polygon(ctx, model.voxels, model.size_x, model.size_y, model.size_z, palette);
     }
+    return NULL;
+}
 
-    assert( mesh->vertex_count <= max_vertex_count);
-    assert( mesh->index_count <= max_index_count);
+// meshes a batch of models one after the other.
+static void _mesh_batch_mesh_task(void* task_data, uint32_t task_index) {
+    _mesh_batch_task_data* data = (_mesh_batch_task_data*)task_data;
+    for (uint32_t cost_index = data->task_first_cost[task_index]; cost_index < data->task_first_cost[task_index + 1]; cost_index++) {
+        uint32_t model_index = data->model_costs[cost_index].model_index;
+        ogt_mesh_voxel_model model;
+        data->get_model(data->models, model_index, &model);
+        data->out_meshes[model_index] = _mesh_batch_mesh_model(data->ctx, model, data->palette, data->algorithm);
+    }
+}
 
-    return mesh;
+// meshes a batch of models, balancing them across the job system by their face counts.
+static bool _mesh_from_model_batch(const ogt_voxel_meshify_context* ctx, const void* models, _mesh_batch_get_model_func get_model, uint32_t model_count,
+    const ogt_mesh_rgba* palette, ogt_mesh_algorithm algorithm, ogt_mesh** out_meshes, const _mesh_job_system& jobs)
+{
+    const uint32_t k_faces_per_task     = 64 * 1024;        // small models are batched into tasks of about this many faces.
+    const uint32_t k_faces_per_parallel = 256 * 1024;       // models with more faces than this have their slices meshed in parallel.
+
+    for (uint32_t model_index = 0; model_index < model_count; model_index++)
+        out_meshes[model_index] = NULL;
+    _mesh_batch_model_cost* model_costs = (_mesh_batch_model_cost*)_voxel_meshify_malloc(ctx, sizeof(_mesh_batch_model_cost) * model_count);
+    uint32_t* task_first_cost = (uint32_t*)_voxel_meshify_malloc(ctx, sizeof(uint32_t) * (model_count + 1));
+    if (model_count && (!model_costs || !task_first_cost)) {
+        _voxel_meshify_free(ctx, task_first_cost);
+        _voxel_meshify_free(ctx, model_costs);
+        return false;
+    }
+
+    // tasks mesh their models serially, so that they never wait on the job system themselves.
+    ogt_voxel_meshify_context task_ctx = *ctx;
+    task_ctx.job_submit_func = NULL;
+    task_ctx.job_wait_func   = NULL;
+    task_ctx.job_user_data   = NULL;
+
+    _mesh_batch_task_data task_data;
+    task_data.ctx             = &task_ctx;
+    task_data.models          = models;
+    task_data.get_model       = get_model;
+    task_data.palette         = palette;
+    task_data.algorithm       = algorithm;
+    task_data.model_costs     = model_costs;
+    task_data.task_first_cost = task_first_cost;
+    task_data.out_meshes      = out_meshes;
+
+    // count the faces of every model, and order them so the most expensive ones are started first and the cheapest ones fill in at the end.
+    _mesh_run_tasks(jobs, _mesh_batch_count_task, &task_data, model_count);
+    if (model_count)
+        qsort(model_costs, model_count, sizeof(_mesh_batch_model_cost), _mesh_batch_compare_model_cost);
+
+    // the most expensive models are meshed one at a time with their slices spread across the job system, if the algorithm allows it.
+    uint32_t cost_index = 0;
+    if (jobs.submit_func && algorithm != ogt_mesh_algorithm_simple) {
+        for (; cost_index < model_count && model_costs[cost_index].face_count > k_faces_per_parallel; cost_index++) {
+            uint32_t model_index = model_costs[cost_index].model_index;
+            ogt_mesh_voxel_model model;
+            get_model(models, model_index, &model);
+            out_meshes[model_index] = (algorithm == ogt_mesh_algorithm_greedy) ?
+                ogt_mesh_from_paletted_voxels_greedy_parallel(ctx, model.voxels, model.size_x, model.size_y, model.size_z, palette, jobs.submit_func, jobs.wait_func, jobs.user_data) :
+                ogt_mesh_from_paletted_voxels_polygon_parallel(ctx, model.voxels, model.size_x, model.size_y, model.size_z, palette, jobs.submit_func, jobs.wait_func, jobs.user_data);
+        }
+    }
+
+    // the rest are meshed a whole model at a time, in tasks of one or more models that add up to about k_faces_per_task faces.
+    uint32_t task_count = 0;
+    uint32_t task_face_count = 0;
+    for (; cost_index < model_count; cost_index++) {
+        if (task_count == 0 || task_face_count + model_costs[cost_index].face_count > k_faces_per_task) {
+            task_first_cost[task_count++] = cost_index;
+            task_face_count = 0;
+        }
+        task_face_count += model_costs[cost_index].face_count;
+    }
+    task_first_cost[task_count] = model_count;
+    _mesh_run_tasks(jobs, _mesh_batch_mesh_task, &task_data, task_count);
+
+    _voxel_meshify_free(ctx, task_first_cost);
+    _voxel_meshify_free(ctx, model_costs);
+
+    bool succeeded = true;
+    for (uint32_t model_index = 0; model_index < model_count; model_index++)
+        succeeded = succeeded && out_meshes[model_index];
+    return succeeded;
+}
+
+bool ogt_mesh_from_paletted_voxel_models(
+    const ogt_voxel_meshify_context* ctx,
+    const ogt_mesh_voxel_model* models, uint32_t model_count, const ogt_mesh_rgba* palette, ogt_mesh_algorithm algorithm, ogt_mesh** out_meshes,
+    ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* job_user_data)
+{
+    _mesh_job_system jobs = _make_job_system(ctx, submit_func, wait_func, job_user_data);
+    return _mesh_from_model_batch(ctx, models, _mesh_batch_get_array_model, model_count, palette, algorithm, out_meshes, jobs);
+}
+
+#if defined(OGT_VOX_H__)
+// fetches a model of a scene, decoding it first if it was read lazily.
+static void _mesh_batch_get_scene_model(const void* models, uint32_t model_index, ogt_mesh_voxel_model* out_model) {
+    const ogt_vox_scene* scene = (const ogt_vox_scene*)models;
+    const ogt_vox_model* model = scene->models[model_index];
+    out_model->voxels = ogt_vox_get_model_voxels(scene, model_index);
+    out_model->size_x = model->size_x;
+    out_model->size_y = model->size_y;
+    out_model->size_z = model->size_z;
+}
+
+bool ogt_mesh_from_scene_models(
+    const ogt_voxel_meshify_context* ctx,
+    const ogt_vox_scene* scene, ogt_mesh_algorithm algorithm, ogt_mesh** out_meshes,
+    ogt_voxel_meshify_job_submit_func submit_func, ogt_voxel_meshify_job_wait_func wait_func, void* job_user_data)
+{
+    _mesh_job_system jobs = _make_job_system(ctx, submit_func, wait_func, job_user_data);
+    return _mesh_from_model_batch(ctx, scene, _mesh_batch_get_scene_model, scene->num_models,
+        (const ogt_mesh_rgba*)&scene->palette.color[0], algorithm, out_meshes, jobs);
 }
+#endif
+
+ogt_mesh_compact* ogt_mesh_compact_from_paletted_voxels(
+    const ogt_voxel_meshify_context* ctx,
+    const uint8_t* voxels, uint32_t size_x, uint32_t size_y, uint32_t size_z, const ogt_mesh_rgba* palette,
+    ogt_mesh_algorithm algorithm, ogt_mesh_compact_format format)
+{
+    const bool is_u8 = (format == ogt_mesh_compact_format_u8_index || format == ogt_mesh_compact_format_u8_rgba);
+    const uint32_t max_size = is_u8 ? 255 : 65535;
+    if (size_x > max_size || size_y > max_size || size_z > max_size)
+        return NULL;
 
+    // the meshers write the compact vertices directly, using the same variant of the algorithm as ogt_mesh_from_paletted_voxels_* would.
+    _mesh_writer out = _make_mesh_compact_writer(format, palette);
+    _mesh_job_system jobs = _make_job_system(ctx, NULL, NULL, NULL);
+    switch (algorithm) {
+        case ogt_mesh_algorithm_simple:
+            return (ogt_mesh_compact*)_mesh_from_paletted_voxels_simple(ctx, voxels, size_x, size_y, size_z, out);
+        case ogt_mesh_algorithm_greedy:
+            return (ogt_mesh_compact*)(jobs.submit_func ?
+                _mesh_from_paletted_voxels_greedy_parallel(ctx, jobs, voxels, size_x, size_y, size_z, out) :
+                _mesh_from_paletted_voxels_greedy_binary(ctx, voxels, size_x, size_y, size_z, out));
+        case ogt_mesh_algorithm_polygon:
+            return (ogt_mesh_compact*)(jobs.submit_func ?
+                _mesh_from_paletted_voxels_polygon_parallel(ctx, jobs, voxels, size_x, size_y, size_z, out) :
+                _mesh_from_paletted_voxels_polygon(ctx, voxels, size_x, size_y, size_z, out));
+    }
+    return NULL;
+}
+
+void ogt_mesh_compact_destroy(const ogt_voxel_meshify_context* ctx, ogt_mesh_compact* mesh)
+{
+    _voxel_meshify_free(ctx, mesh);
+}
 
 void ogt_mesh_destroy(const ogt_voxel_meshify_context* ctx, ogt_mesh* mesh )
 {